@@ -11,10 +11,12 @@ BufferPoolManager::BufferPoolManager(size_t pool_size,DiskManager *disk_manager,
     : pool_size_(pool_size), disk_manager_(disk_manager),log_manager_(log_manager)
       {
   pages_ = new Page[pool_size_];
+  frames_ = new char[pool_size_ * PAGE_SIZE]();
   page_table_ = new ExtendibleHash<page_id_t, Page *>(BUCKET_SIZE);
   replacer_ = new LRUReplacer<Page *>;
   free_list_ = new std::list<Page *>;
   for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].data_ = frames_ + i * PAGE_SIZE;
     free_list_->push_back(&pages_[i]);
   }
 }
@@ -24,7 +26,10 @@ BufferPoolManager::BufferPoolManager(size_t pool_size,DiskManager *disk_manager,
  * WARNING: Do Not Edit This Function
  */
 BufferPoolManager::~BufferPoolManager() {
+  for (auto page : mapped_pages_)
+    delete page;
   delete[] pages_;
+  delete[] frames_;
   delete page_table_;
   delete replacer_;
   delete free_list_;
@@ -40,9 +45,14 @@ BufferPoolManager::~BufferPoolManager() {
  * entry for the new page.
  * 4. Update page metadata, read page content from disk file and return page
  * pointer
+ * Return nullptr if all pages are pinned or the page fails checksum
+ * verification
  */
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
     std::lock_guard<std::mutex> guard(latch_);
+    if (disk_manager_->IsMapped()) {
+        return FetchMappedPage(page_id);
+    }
     Page *targetPage=nullptr;
     if(page_table_->Find(page_id,targetPage))
     {
@@ -56,7 +66,12 @@ Page *BufferPoolManager::FetchPage(page_id_t page_id) {
         {
             return targetPage;
         }
-        disk_manager_->ReadPage(page_id, targetPage->GetData());
+        if (!disk_manager_->ReadPage(page_id, targetPage->GetData())) {
+            // corrupted page (checksum mismatch), do not hand it out
+            targetPage->ResetMemory();
+            free_list_->push_back(targetPage);
+            return nullptr;
+        }
         targetPage->pin_count_ = 1;
         targetPage->page_id_ = page_id;
         page_table_->Insert(page_id, targetPage);
@@ -83,6 +98,10 @@ bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
             return false;
         }
         page->pin_count_--;
+        if (disk_manager_->IsMapped()) {
+            // mapped pages are never evicted nor written back
+            return true;
+        }
         if (page->pin_count_ == 0) {
             replacer_->Insert(page);
         }
@@ -113,6 +132,21 @@ bool BufferPoolManager::FlushPage(page_id_t page_id) {
         return true;
 }
 
+/*
+ * Write every dirty page in the buffer pool back to disk, used before the
+ * storage engine shuts down
+ */
+void BufferPoolManager::FlushAllPages() {
+        std::lock_guard<std::mutex> guard(latch_);
+        for (size_t i = 0; i < pool_size_; i++) {
+            Page *page = &pages_[i];
+            if (page->page_id_ != INVALID_PAGE_ID && page->is_dirty_) {
+                disk_manager_->WritePage(page->page_id_, page->GetData());
+                page->is_dirty_ = false;
+            }
+        }
+}
+
 /**
  * User should call this method for deleting a page. This routine will call
  * disk manager to deallocate the page. First, if page is found within page
@@ -123,6 +157,9 @@ bool BufferPoolManager::FlushPage(page_id_t page_id) {
  */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
         std::lock_guard<std::mutex> guard(latch_);
+        if (disk_manager_->IsReadOnly()) {
+            return false;
+        }
         Page *page = nullptr;
         if (page_table_->Find(page_id, page)) {
             if (page->GetPinCount() != 0) {
@@ -144,6 +181,46 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
         return true;
 }
 
+/**
+ * Add a data file to the tablespace, return its id or -1 if none can be added
+ */
+int BufferPoolManager::CreateFile() { return disk_manager_->CreateFile(); }
+
+/**
+ * Drop a whole data file of the tablespace: forget every cached page of it
+ * and let the disk manager unlink the file. Return false if one of its pages
+ * is still pinned or the file can not be dropped
+ */
+bool BufferPoolManager::DropFile(int file_id) {
+        std::lock_guard<std::mutex> guard(latch_);
+        if (file_id == 0 || !disk_manager_->HasFile(file_id)) {
+            return false;
+        }
+        for (size_t i = 0; i < pool_size_; i++) {
+            Page *page = &pages_[i];
+            if (page->page_id_ != INVALID_PAGE_ID &&
+                DiskManager::GetFileId(page->page_id_) == file_id &&
+                page->pin_count_ != 0) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < pool_size_; i++) {
+            Page *page = &pages_[i];
+            if (page->page_id_ == INVALID_PAGE_ID ||
+                DiskManager::GetFileId(page->page_id_) != file_id) {
+                continue;
+            }
+            // no write back, the file is going away
+            replacer_->Erase(page);
+            page_table_->Remove(page->page_id_);
+            page->page_id_ = INVALID_PAGE_ID;
+            page->is_dirty_ = false;
+            page->ResetMemory();
+            free_list_->push_back(page);
+        }
+        return disk_manager_->DropFile(file_id);
+}
+
 /**
  * User should call this method if needs to create a new page. This routine
  * will call disk manager to allocate a page.
@@ -151,19 +228,28 @@ bool BufferPoolManager::DeletePage(page_id_t page_id) {
  * from free list or lru replacer(NOTE: always choose from free list first),
  * update new page's metadata, zero out memory and add corresponding entry
  * into page table. return nullptr if all the pages in pool are pinned
+ * file_id: data file of the tablespace the page is allocated in, nullptr is
+ * returned as well if it does not exist or is full
  */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
+Page *BufferPoolManager::NewPage(page_id_t &page_id, int file_id) {
         std::lock_guard<std::mutex> guard(latch_);
+        if (disk_manager_->IsReadOnly()) {
+            return nullptr;
+        }
 
         Page *newPage = nullptr;
-        newPage = findUnusedPage();
+        newPage = findTargetPage();
 
         if (newPage == nullptr) {
             return newPage;
         }
 
         // now newPage is clear
-        page_id = disk_manager_->AllocatePage();
+        page_id = disk_manager_->AllocatePage(file_id);
+        if (page_id == INVALID_PAGE_ID) {
+            free_list_->push_back(newPage);
+            return nullptr;
+        }
         newPage->page_id_ = page_id;
         newPage->is_dirty_ = true;
         newPage->pin_count_ = 1;
@@ -202,6 +288,28 @@ Page *BufferPoolManager::NewPage(page_id_t &page_id) {
         return page;
     }
 
+    /*
+     * Read-only mode: hand out a view into the mmap'ed db file. Views are
+     * created on first access and stay in page table until destruction.
+     */
+    Page *BufferPoolManager::FetchMappedPage(page_id_t page_id)
+    {
+        Page *page = nullptr;
+        if (!page_table_->Find(page_id, page)) {
+            char *data = disk_manager_->GetMappedPage(page_id);
+            if (data == nullptr) {
+                return nullptr;
+            }
+            page = new Page;
+            page->data_ = data;
+            page->page_id_ = page_id;
+            page_table_->Insert(page_id, page);
+            mapped_pages_.push_back(page);
+        }
+        page->pin_count_++;
+        return page;
+    }
+
     int BufferPoolManager::GetPagePinCount(const page_id_t &page_id) {
         Page *page = nullptr;
         if (!page_table_->Find(page_id, page)) {
@@ -92,7 +92,12 @@ namespace scudb {
         }
 
         auto currentNode = getKey->second;
-        if(currentNode == head)//欲删除的结点是头结点
+        if(currentNode==head && currentNode==tail)//链表中只有一个元素
+        {
+            head=nullptr;
+            tail=nullptr;
+        }
+        else if(currentNode == head)//欲删除的结点是头结点
         {
             currentNode->nextNode->preNode = nullptr;
             head = currentNode->nextNode;
@@ -102,11 +107,6 @@ namespace scudb {
             currentNode->preNode->nextNode=nullptr;
             tail=currentNode->preNode;
         }
-        else if(currentNode==head && currentNode==tail)//链表中只有一个元素
-        {
-            head=nullptr;
-            tail=nullptr;
-        }
         else
         {
             currentNode->nextNode->preNode=currentNode->preNode;
@@ -0,0 +1,82 @@
+/**
+ * root_catalog.cpp
+ */
+#include "catalog/root_catalog.h"
+#include "common/exception.h"
+#include "page/header_page.h"
+
+namespace scudb {
+
+bool RootCatalog::GetRootId(const std::string &name, page_id_t &root_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  auto it = root_ids_.find(name);
+  if (it == root_ids_.end())
+    return false;
+  root_id = it->second;
+  return true;
+}
+
+bool RootCatalog::SetRootId(const std::string &name, page_id_t root_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  auto it = root_ids_.find(name);
+  if (it != root_ids_.end() && it->second == root_id)
+    return true;
+  HeaderPage *header_page = FetchHeaderPage();
+  header_page->WLatch();
+  bool written = it == root_ids_.end()
+                     ? header_page->InsertRecord(name, root_id)
+                     : header_page->UpdateRecord(name, root_id);
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, written);
+  // the cached id only changes with the record, a failed write leaves both
+  if (written)
+    root_ids_[name] = root_id;
+  return written;
+}
+
+bool RootCatalog::HasRoom(size_t records) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  return root_ids_.size() + records <=
+         static_cast<size_t>(HeaderPage::MAX_RECORD_COUNT);
+}
+
+bool RootCatalog::DeleteRecord(const std::string &name) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  if (root_ids_.erase(name) == 0)
+    return false;
+  HeaderPage *header_page = FetchHeaderPage();
+  header_page->WLatch();
+  bool deleted = header_page->DeleteRecord(name);
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, deleted);
+  return deleted;
+}
+
+HeaderPage *RootCatalog::FetchHeaderPage() {
+  Page *page = buffer_pool_manager_->FetchPage(HEADER_PAGE_ID);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_CATALOG, "out of memory");
+  return static_cast<HeaderPage *>(page);
+}
+
+void RootCatalog::Load() {
+  if (loaded_)
+    return;
+  HeaderPage *header_page = FetchHeaderPage();
+  header_page->RLatch();
+  for (int i = 0; i < header_page->GetRecordCount(); i++) {
+    std::string name;
+    page_id_t root_id;
+    header_page->GetRecord(i, name, root_id);
+    root_ids_[name] = root_id;
+  }
+  header_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, false);
+  loaded_ = true;
+}
+
+} // namespace scudb
@@ -4,4 +4,6 @@ namespace scudb {
   std::atomic<bool> ENABLE_LOGGING(false);  // for virtual table
   std::chrono::duration<long long int> LOG_TIMEOUT =
    std::chrono::seconds(1);
+  std::chrono::duration<long long int> COMPACTION_TIMEOUT =
+   std::chrono::seconds(1);
 }
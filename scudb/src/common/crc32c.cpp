@@ -0,0 +1,63 @@
+/**
+ * crc32c.cpp
+ */
+#include <cstring>
+
+#ifdef __SSE4_2__
+#include <nmmintrin.h>
+#endif
+
+#include "common/crc32c.h"
+
+namespace scudb {
+
+#ifdef __SSE4_2__
+
+uint32_t Crc32c(const char *data, size_t len, uint32_t crc) {
+  uint64_t c = ~crc;
+  // 8 bytes per instruction, memcpy keeps unaligned loads well defined
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+    c = _mm_crc32_u64(c, word);
+    data += 8;
+    len -= 8;
+  }
+  uint32_t c32 = static_cast<uint32_t>(c);
+  while (len > 0) {
+    c32 = _mm_crc32_u8(c32, static_cast<uint8_t>(*data));
+    data++;
+    len--;
+  }
+  return ~c32;
+}
+
+#else
+
+namespace {
+// reflected polynomial 0x1EDC6F41
+struct Crc32cTable {
+  uint32_t entries[256];
+  Crc32cTable() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++)
+        c = (c & 1) ? (c >> 1) ^ 0x82F63B78 : c >> 1;
+      entries[i] = c;
+    }
+  }
+};
+const Crc32cTable crc32c_table;
+} // namespace
+
+uint32_t Crc32c(const char *data, size_t len, uint32_t crc) {
+  uint32_t c = ~crc;
+  for (size_t i = 0; i < len; i++)
+    c = crc32c_table.entries[(c ^ static_cast<uint8_t>(data[i])) & 0xFF] ^
+        (c >> 8);
+  return ~c;
+}
+
+#endif
+
+} // namespace scudb
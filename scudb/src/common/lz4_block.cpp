@@ -0,0 +1,163 @@
+/**
+ * lz4_block.cpp
+ */
+#include <cstdint>
+#include <cstring>
+
+#include "common/lz4_block.h"
+
+namespace scudb {
+
+namespace {
+const int MIN_MATCH = 4;
+const int LAST_LITERALS = 5; // last bytes of a block are always literals
+const int MF_LIMIT = 12;     // last match must start this far before the end
+const int MAX_OFFSET = 65535;
+const int HASH_LOG = 12;
+
+inline uint32_t Read32(const unsigned char *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+// write length beyond the 15 held by the token, return false on overflow
+inline bool WriteLength(int len, unsigned char *&op, const unsigned char *end) {
+  for (; len >= 255; len -= 255) {
+    if (op >= end)
+      return false;
+    *op++ = 255;
+  }
+  if (op >= end)
+    return false;
+  *op++ = static_cast<unsigned char>(len);
+  return true;
+}
+
+// read length extension following a saturated token nibble
+inline bool ReadLength(int &len, const unsigned char *&ip,
+                       const unsigned char *end) {
+  unsigned char b;
+  do {
+    if (ip >= end)
+      return false;
+    b = *ip++;
+    len += b;
+  } while (b == 255);
+  return true;
+}
+
+// emit token, literals and (if match_len > 0) the match part of a sequence
+bool WriteSequence(const unsigned char *literals, int literal_len, int offset,
+                   int match_len, unsigned char *&op,
+                   const unsigned char *end) {
+  if (op >= end)
+    return false;
+  unsigned char *token = op++;
+  *token = static_cast<unsigned char>((literal_len < 15 ? literal_len : 15)
+                                      << 4);
+  if (literal_len >= 15 && !WriteLength(literal_len - 15, op, end))
+    return false;
+  if (end - op < literal_len)
+    return false;
+  memcpy(op, literals, literal_len);
+  op += literal_len;
+  if (match_len == 0)
+    return true;
+
+  if (end - op < 2)
+    return false;
+  *op++ = static_cast<unsigned char>(offset);
+  *op++ = static_cast<unsigned char>(offset >> 8);
+  int ml = match_len - MIN_MATCH;
+  *token |= static_cast<unsigned char>(ml < 15 ? ml : 15);
+  if (ml >= 15 && !WriteLength(ml - 15, op, end))
+    return false;
+  return true;
+}
+} // namespace
+
+/*
+ * Greedy single pass: look up the last position with the same 4 byte prefix,
+ * take the match if it is within range, otherwise advance one byte
+ */
+int Lz4Compress(const char *src, int src_len, char *dst, int dst_capacity) {
+  const unsigned char *base = reinterpret_cast<const unsigned char *>(src);
+  unsigned char *op = reinterpret_cast<unsigned char *>(dst);
+  const unsigned char *end = op + dst_capacity;
+  int table[1 << HASH_LOG];
+  for (int &entry : table)
+    entry = -1;
+
+  int anchor = 0;
+  int ip = 0;
+  int match_limit = src_len - LAST_LITERALS;
+  while (ip + MF_LIMIT <= src_len) {
+    uint32_t sequence = Read32(base + ip);
+    uint32_t h = Hash(sequence);
+    int ref = table[h];
+    table[h] = ip;
+    if (ref < 0 || ip - ref > MAX_OFFSET || Read32(base + ref) != sequence) {
+      ip++;
+      continue;
+    }
+    int len = MIN_MATCH;
+    while (ip + len < match_limit && base[ref + len] == base[ip + len])
+      len++;
+    if (!WriteSequence(base + anchor, ip - anchor, ip - ref, len, op, end))
+      return 0;
+    ip += len;
+    anchor = ip;
+  }
+  if (!WriteSequence(base + anchor, src_len - anchor, 0, 0, op, end))
+    return 0;
+  return static_cast<int>(op - reinterpret_cast<unsigned char *>(dst));
+}
+
+int Lz4Decompress(const char *src, int src_len, char *dst, int dst_capacity) {
+  const unsigned char *ip = reinterpret_cast<const unsigned char *>(src);
+  const unsigned char *ip_end = ip + src_len;
+  unsigned char *base = reinterpret_cast<unsigned char *>(dst);
+  unsigned char *op = base;
+  unsigned char *op_end = base + dst_capacity;
+
+  while (ip < ip_end) {
+    unsigned char token = *ip++;
+    int literal_len = token >> 4;
+    if (literal_len == 15 && !ReadLength(literal_len, ip, ip_end))
+      return -1;
+    if (ip_end - ip < literal_len || op_end - op < literal_len)
+      return -1;
+    memcpy(op, ip, literal_len);
+    ip += literal_len;
+    op += literal_len;
+    // the last sequence has no match part
+    if (ip == ip_end)
+      break;
+
+    if (ip_end - ip < 2)
+      return -1;
+    int offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > op - base)
+      return -1;
+    int match_len = token & 15;
+    if (match_len == 15 && !ReadLength(match_len, ip, ip_end))
+      return -1;
+    match_len += MIN_MATCH;
+    if (op_end - op < match_len)
+      return -1;
+    // byte by byte, source and destination may overlap
+    const unsigned char *match = op - offset;
+    for (int i = 0; i < match_len; i++)
+      op[i] = match[i];
+    op += match_len;
+  }
+  return static_cast<int>(op - base);
+}
+
+} // namespace scudb
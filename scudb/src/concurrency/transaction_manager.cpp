@@ -50,25 +50,9 @@ void TransactionManager::Commit(Transaction *txn) {
 }
 
 void TransactionManager::Abort(Transaction *txn) {
-  txn->SetState(TransactionState::ABORTED);
   // rollback before releasing lock
-  auto write_set = txn->GetWriteSet();
-  while (!write_set->empty()) {
-    auto &item = write_set->back();
-    auto table = item.table_;
-    if (item.wtype_ == WType::DELETE) {
-      LOG_DEBUG("rollback delete");
-      table->RollbackDelete(item.rid_, txn);
-    } else if (item.wtype_ == WType::INSERT) {
-      LOG_DEBUG("rollback insert");
-      table->ApplyDelete(item.rid_, txn);
-    } else if (item.wtype_ == WType::UPDATE) {
-      LOG_DEBUG("rollback update");
-      table->UpdateTuple(item.tuple_, item.rid_, txn);
-    }
-    write_set->pop_back();
-  }
-  write_set->clear();
+  RollbackTo(txn, 0);
+  txn->SetState(TransactionState::ABORTED);
 
   if (ENABLE_LOGGING) {
     // TODO: write log and update transaction's prev_lsn here
@@ -85,4 +69,27 @@ void TransactionManager::Abort(Transaction *txn) {
     lock_manager_->Unlock(txn, locked_rid);
   }
 }
+
+void TransactionManager::RollbackTo(Transaction *txn, size_t write_count) {
+  // the writes that undo are not recorded while the state is ABORTED
+  TransactionState state = txn->GetState();
+  txn->SetState(TransactionState::ABORTED);
+  auto write_set = txn->GetWriteSet();
+  while (write_set->size() > write_count) {
+    auto &item = write_set->back();
+    auto table = item.table_;
+    if (item.wtype_ == WType::DELETE) {
+      LOG_DEBUG("rollback delete");
+      table->RollbackDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::INSERT) {
+      LOG_DEBUG("rollback insert");
+      table->ApplyDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::UPDATE) {
+      LOG_DEBUG("rollback update");
+      table->UpdateTuple(item.tuple_, item.rid_, txn);
+    }
+    write_set->pop_back();
+  }
+  txn->SetState(state);
+}
 } // namespace scudb
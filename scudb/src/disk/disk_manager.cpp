@@ -1,62 +1,95 @@
 /**
  * disk_manager.cpp
  */
+#include <algorithm>
 #include <assert.h>
 #include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 
+#include "common/crc32c.h"
 #include "common/logger.h"
+#include "common/lz4_block.h"
 #include "disk/disk_manager.h"
 
 namespace scudb {
 
 static char *buffer_used = nullptr;
 
+// header in front of every page record of a compressed db file
+struct RecordHeader {
+  page_id_t page_id; // INVALID_PAGE_ID for a dead (moved) record
+  uint16_t capacity; // payload bytes reserved after the header
+  uint16_t length;   // payload bytes used, PAGE_SIZE means not compressed
+  uint32_t crc;      // crc32c of the payload, only with checksum enabled
+  uint32_t seq;      // write sequence number, the newest record of a page wins
+};
+static const size_t RECORD_ALIGN = 32; // capacity granularity, leaves slack
+                                       // for rewrites that compress worse
+
+// page number of a page id within its data file
+static inline size_t PageNo(page_id_t page_id) {
+  return page_id & ((1 << FILE_ID_SHIFT) - 1);
+}
+
 /**
- * Constructor: open/create a single database file & log file
+ * Constructor: open/create the database file & log file, and open every other
+ * data file of the tablespace that exists on disk
  * @input db_file: database file name
+ * @input read_only: map existing data files instead of opening streams, no log
+ * file is created in this mode
+ * @input checksum: store a CRC32C trailer with every page and verify it on
+ * read, must match the setting the files were written with
+ * @input compressed: store pages as compressed records, must match the setting
+ * the files were written with. Read-only compressed files are read through
+ * streams, not mapped
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), next_page_id_(0), num_flushes_(0), flush_log_(false),
-      flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, bool read_only,
+                         bool checksum, bool compressed)
+    : files_(MAX_FILE_ID + 1, nullptr), file_name_(db_file), num_flushes_(0),
+      flush_log_(false), flush_log_f_(nullptr), read_only_(read_only),
+      checksum_(checksum),
+      slot_size_(checksum ? PAGE_SIZE + CHECKSUM_SIZE : PAGE_SIZE),
+      num_checksum_failures_(0), compressed_(compressed) {
   std::string::size_type n = file_name_.find(".");
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
+  if (!read_only_) {
+    log_name_ = file_name_.substr(0, n) + ".log";
 
-  log_io_.open(log_name_,
-               std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::app |
-                                std::ios::out);
-    log_io_.close();
-    // reopen with original mode
     log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app |
                                 std::ios::out);
+    // directory or file does not exist
+    if (!log_io_.is_open()) {
+      log_io_.clear();
+      // create a new file
+      log_io_.open(log_name_, std::ios::binary | std::ios::trunc |
+                                  std::ios::app | std::ios::out);
+      log_io_.close();
+      // reopen with original mode
+      log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app |
+                                  std::ios::out);
+    }
   }
 
-  db_io_.open(db_file,
-              std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  files_[0] = OpenDataFile(file_name_);
+  for (int file_id = 1; file_id <= MAX_FILE_ID; file_id++) {
+    std::string name = GetDataFileName(file_id);
+    if (GetFileSize(name) >= 0)
+      files_[file_id] = OpenDataFile(name);
   }
 }
 
 DiskManager::~DiskManager() {
-  db_io_.close();
+  for (auto file : files_)
+    if (file != nullptr)
+      CloseDataFile(file);
   log_io_.close();
 }
 
@@ -64,40 +97,170 @@ DiskManager::~DiskManager() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  size_t offset = page_id * PAGE_SIZE;
+  if (read_only_) {
+    LOG_DEBUG("write to a read-only database file");
+    return;
+  }
+  DataFile *file = GetDataFile(page_id);
+  if (file == nullptr) {
+    LOG_DEBUG("write to a missing data file");
+    return;
+  }
+  if (compressed_) {
+    WriteCompressedPage(file, page_id, page_data);
+    return;
+  }
+  size_t offset = PageNo(page_id) * slot_size_;
   // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
+  file->io.seekp(offset);
+  if (checksum_) {
+    // page and trailer go out in a single write
+    char slot[PAGE_SIZE + CHECKSUM_SIZE];
+    memcpy(slot, page_data, PAGE_SIZE);
+    uint32_t crc = Crc32c(page_data, PAGE_SIZE);
+    memcpy(slot + PAGE_SIZE, &crc, CHECKSUM_SIZE);
+    file->io.write(slot, slot_size_);
+  } else {
+    file->io.write(page_data, PAGE_SIZE);
+  }
   // check for I/O error
-  if (db_io_.bad()) {
+  if (file->io.bad()) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
+  file->file_size = std::max(file->file_size, offset + slot_size_);
   // needs to flush to keep disk file in sync
-  db_io_.flush();
+  file->io.flush();
 }
 
 /**
  * Read the contents of the specified page into the given memory area
+ * @return: false if checksums are enabled and the stored page does not match
+ * its trailer, page_data is zeroed in that case
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  int offset = page_id * PAGE_SIZE;
+bool DiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  DataFile *file = GetDataFile(page_id);
+  if (file == nullptr) {
+    LOG_DEBUG("I/O error while reading");
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  if (compressed_)
+    return ReadCompressedPage(file, page_id, page_data);
+  if (read_only_) {
+    size_t mapped_offset = PageNo(page_id) * slot_size_;
+    if (file->mapped_data == nullptr ||
+        mapped_offset + slot_size_ > file->mapped_size) {
+      LOG_DEBUG("I/O error while reading");
+      memset(page_data, 0, PAGE_SIZE);
+      return true;
+    }
+    if (checksum_ &&
+        !VerifyChecksum(page_id, file->mapped_data + mapped_offset)) {
+      memset(page_data, 0, PAGE_SIZE);
+      return false;
+    }
+    memcpy(page_data, file->mapped_data + mapped_offset, PAGE_SIZE);
+    return true;
+  }
+  size_t offset = PageNo(page_id) * slot_size_;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (offset > file->file_size) {
     LOG_DEBUG("I/O error while reading");
     // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
+    return true;
+  }
+  // set read cursor to offset
+  file->io.seekp(offset);
+  if (!checksum_) {
+    file->io.read(page_data, PAGE_SIZE);
     // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
+    int read_count = file->io.gcount();
     if (read_count < PAGE_SIZE) {
       LOG_DEBUG("Read less than a page");
       // std::cerr << "Read less than a page" << std::endl;
+      file->io.clear();
       memset(page_data + read_count, 0, PAGE_SIZE - read_count);
     }
+    return true;
+  }
+
+  char slot[PAGE_SIZE + CHECKSUM_SIZE];
+  file->io.read(slot, slot_size_);
+  int read_count = file->io.gcount();
+  if (read_count == 0) {
+    // reading exactly at the end of file, same as a never written page
+    file->io.clear();
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  if (read_count < static_cast<int>(slot_size_)) {
+    // a page is always written together with its trailer
+    file->io.clear();
+    memset(slot + read_count, 0, slot_size_ - read_count);
   }
+  if (!VerifyChecksum(page_id, slot)) {
+    memset(page_data, 0, PAGE_SIZE);
+    return false;
+  }
+  memcpy(page_data, slot, PAGE_SIZE);
+  return true;
+}
+
+/**
+ * Return the address of the specified page inside the read-only mapping
+ * NOTE: only valid in read-only mode, the trailing partial page (if any) is not
+ * handed out, neither is a page failing checksum verification
+ */
+char *DiskManager::GetMappedPage(page_id_t page_id) {
+  DataFile *file = GetDataFile(page_id);
+  if (file == nullptr || file->mapped_data == nullptr)
+    return nullptr;
+  size_t offset = PageNo(page_id) * slot_size_;
+  if (offset + slot_size_ > file->mapped_size)
+    return nullptr;
+  if (checksum_ && !VerifyChecksum(page_id, file->mapped_data + offset))
+    return nullptr;
+  return file->mapped_data + offset;
+}
+
+/**
+ * Add a new data file to the tablespace, pages are allocated in it by passing
+ * the returned id to AllocatePage
+ * @return: file id, -1 if read-only or all MAX_FILE_ID files are in use
+ */
+int DiskManager::CreateFile() {
+  if (read_only_)
+    return -1;
+  for (int file_id = 1; file_id <= MAX_FILE_ID; file_id++) {
+    if (files_[file_id] != nullptr)
+      continue;
+    std::string name = GetDataFileName(file_id);
+    // a leftover that failed to open before is overwritten
+    remove(name.c_str());
+    files_[file_id] = OpenDataFile(name);
+    return files_[file_id] == nullptr ? -1 : file_id;
+  }
+  LOG_DEBUG("too many data files");
+  return -1;
+}
+
+/**
+ * Close and unlink a data file, the caller has to make sure no page of it is
+ * still cached
+ */
+bool DiskManager::DropFile(int file_id) {
+  if (read_only_ || !HasFile(file_id) || file_id == 0)
+    return false;
+  DataFile *file = files_[file_id];
+  files_[file_id] = nullptr;
+  std::string name = file->name;
+  CloseDataFile(file);
+  return remove(name.c_str()) == 0;
+}
+
+bool DiskManager::HasFile(int file_id) const {
+  return file_id >= 0 && file_id <= MAX_FILE_ID && files_[file_id] != nullptr;
 }
 
 /**
@@ -158,9 +321,19 @@ bool DiskManager::ReadLog(char *log_data, int size, int offset) {
 
 /**
  * Allocate new page (operations like create index/table)
- * For now just keep an increasing counter
+ * For now just keep an increasing counter per data file
  */
-page_id_t DiskManager::AllocatePage() { return next_page_id_++; }
+page_id_t DiskManager::AllocatePage(int file_id) {
+  if (!HasFile(file_id))
+    return INVALID_PAGE_ID;
+  page_id_t page_no = files_[file_id]->next_page_id++;
+  if (page_no >= (1 << FILE_ID_SHIFT)) {
+    LOG_DEBUG("data file %d is full", file_id);
+    files_[file_id]->next_page_id--;
+    return INVALID_PAGE_ID;
+  }
+  return (file_id << FILE_ID_SHIFT) | page_no;
+}
 
 /**
  * Deallocate page (operations like drop index/table)
@@ -180,10 +353,288 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 bool DiskManager::GetFlushState() const { return flush_log_; }
 
+/**
+ * Returns number of pages rejected by checksum verification so far
+ */
+int DiskManager::GetNumChecksumFailures() const {
+  return num_checksum_failures_;
+}
+
+/**
+ * Private helper function to check a page slot (data + trailer) read from disk
+ * An all zero slot is a page that was allocated but never written (hole in the
+ * file) and is accepted as an empty page
+ */
+bool DiskManager::VerifyChecksum(page_id_t page_id, const char *slot) {
+  uint32_t stored;
+  memcpy(&stored, slot + PAGE_SIZE, CHECKSUM_SIZE);
+  if (stored == Crc32c(slot, PAGE_SIZE))
+    return true;
+  if (stored == 0) {
+    size_t i = 0;
+    while (i < PAGE_SIZE && slot[i] == 0)
+      i++;
+    if (i == PAGE_SIZE)
+      return true;
+  }
+  num_checksum_failures_++;
+  LOG_DEBUG("checksum mismatch on page %d", page_id);
+  return false;
+}
+
+/**
+ * Private helper function to name the data files of the tablespace
+ * e.g. file 3 of "vtable.db" is "vtable_3.db"
+ */
+std::string DiskManager::GetDataFileName(int file_id) {
+  if (file_id == 0)
+    return file_name_;
+  std::string::size_type n = file_name_.rfind(".");
+  return file_name_.substr(0, n) + "_" + std::to_string(file_id) +
+         file_name_.substr(n);
+}
+
+/**
+ * Private helper function to open (and create if needed) a data file in the
+ * mode of this disk manager
+ * @return: nullptr if the file can not be opened
+ */
+DataFile *DiskManager::OpenDataFile(const std::string &name) {
+  DataFile *file = new DataFile;
+  file->name = name;
+  if (read_only_ && compressed_) {
+    file->io.open(name, std::ios::binary | std::ios::in);
+    if (!file->io.is_open()) {
+      LOG_DEBUG("can not open db file for reading");
+      delete file;
+      return nullptr;
+    }
+    file->file_size = std::max<int64_t>(GetFileSize(name), 0);
+    LoadPageRecords(file);
+    return file;
+  }
+  if (read_only_) {
+    int fd = open(name.c_str(), O_RDONLY);
+    if (fd < 0) {
+      LOG_DEBUG("can not open db file for read-only mapping");
+      delete file;
+      return nullptr;
+    }
+    struct stat stat_buf;
+    if (fstat(fd, &stat_buf) == 0 && stat_buf.st_size > 0) {
+      void *addr = mmap(nullptr, stat_buf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (addr != MAP_FAILED) {
+        file->mapped_data = static_cast<char *>(addr);
+        file->mapped_size = stat_buf.st_size;
+        file->file_size = file->mapped_size;
+        file->next_page_id = file->mapped_size / slot_size_;
+      } else {
+        LOG_DEBUG("mmap of db file failed");
+      }
+    }
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    return file;
+  }
+
+  file->io.open(name,
+                std::ios::binary | std::ios::in | std::ios::out | std::ios::out);
+  // directory or file does not exist
+  if (!file->io.is_open()) {
+    file->io.clear();
+    // create a new file
+    file->io.open(name, std::ios::binary | std::ios::trunc | std::ios::out);
+    file->io.close();
+    // reopen with original mode
+    file->io.open(name, std::ios::binary | std::ios::in | std::ios::out);
+  }
+  if (!file->io.is_open()) {
+    LOG_DEBUG("can not open db file");
+    delete file;
+    return nullptr;
+  }
+  file->file_size = std::max<int64_t>(GetFileSize(name), 0);
+  if (compressed_) {
+    LoadPageRecords(file);
+  } else {
+    // continue allocating after the last (possibly partial) page on disk
+    file->next_page_id = (file->file_size + slot_size_ - 1) / slot_size_;
+  }
+  return file;
+}
+
+void DiskManager::CloseDataFile(DataFile *file) {
+  if (file->mapped_data != nullptr)
+    munmap(file->mapped_data, file->mapped_size);
+  file->io.close();
+  delete file;
+}
+
+/**
+ * Private helper function to find the data file holding a page
+ * @return: nullptr for invalid page ids and missing files
+ */
+DataFile *DiskManager::GetDataFile(page_id_t page_id) {
+  if (page_id < 0)
+    return nullptr;
+  return files_[GetFileId(page_id)];
+}
+
+/**
+ * Private helper function to rebuild the page number -> record map of a
+ * compressed data file by walking the record headers from the start of file
+ */
+void DiskManager::LoadPageRecords(DataFile *file) {
+  RecordHeader header;
+  while (file->end_offset + sizeof(header) <= file->file_size) {
+    file->io.seekp(file->end_offset);
+    file->io.read(reinterpret_cast<char *>(&header), sizeof(header));
+    // a record never reserves more than a page, the sizes of a torn or
+    // corrupt header must not be trusted
+    if (file->io.gcount() < static_cast<int>(sizeof(header)) ||
+        header.capacity == 0 || header.capacity > PAGE_SIZE ||
+        header.length > header.capacity) {
+      LOG_DEBUG("malformed record header, ignoring rest of db file");
+      break;
+    }
+    file->next_seq = std::max(file->next_seq, header.seq + 1);
+    if (header.page_id == INVALID_PAGE_ID) {
+      file->free_records.emplace(header.capacity, file->end_offset);
+    } else if (header.page_id >= 0) {
+      size_t page_no = PageNo(header.page_id);
+      if (page_no >= file->page_records.size())
+        file->page_records.resize(page_no + 1);
+      PageRecord &record = file->page_records[page_no];
+      // a crash while a page moved leaves its old record alive too
+      if (record.capacity != 0 && record.seq > header.seq) {
+        file->free_records.emplace(header.capacity, file->end_offset);
+      } else {
+        if (record.capacity != 0)
+          file->free_records.emplace(record.capacity, record.offset);
+        record.offset = file->end_offset;
+        record.capacity = header.capacity;
+        record.seq = header.seq;
+      }
+    }
+    file->end_offset += sizeof(header) + header.capacity;
+  }
+  file->io.clear();
+  file->next_page_id = file->page_records.size();
+}
+
+/**
+ * Private helper function to write a page as a compressed record
+ * The record is rewritten in place when it still fits, otherwise it moves to
+ * the smallest dead record that is large enough or to the end of file, and the
+ * old record is marked dead. A crash in between leaves both alive, the loader
+ * keeps the one with the higher sequence number
+ */
+void DiskManager::WriteCompressedPage(DataFile *file, page_id_t page_id,
+                                      const char *page_data) {
+  char buffer[sizeof(RecordHeader) + PAGE_SIZE];
+  RecordHeader *header = reinterpret_cast<RecordHeader *>(buffer);
+  char *payload = buffer + sizeof(RecordHeader);
+  int length = Lz4Compress(page_data, PAGE_SIZE, payload, PAGE_SIZE - 1);
+  if (length == 0) {
+    // incompressible, store as is
+    memcpy(payload, page_data, PAGE_SIZE);
+    length = PAGE_SIZE;
+  }
+
+  size_t page_no = PageNo(page_id);
+  if (page_no >= file->page_records.size())
+    file->page_records.resize(page_no + 1);
+  PageRecord &record = file->page_records[page_no];
+  PageRecord old_record = record;
+  if (record.capacity < length) {
+    uint16_t capacity =
+        (length + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+    auto it = file->free_records.lower_bound(capacity);
+    if (it != file->free_records.end()) {
+      record.capacity = it->first;
+      record.offset = it->second;
+      file->free_records.erase(it);
+    } else {
+      record.capacity = capacity;
+      record.offset = file->end_offset;
+      file->end_offset += sizeof(RecordHeader) + capacity;
+    }
+  }
+
+  header->page_id = page_id;
+  header->capacity = record.capacity;
+  header->length = length;
+  header->crc = checksum_ ? Crc32c(payload, length) : 0;
+  header->seq = record.seq = file->next_seq++;
+  file->io.seekp(record.offset);
+  file->io.write(buffer, sizeof(RecordHeader) + length);
+  if (old_record.capacity != 0 && old_record.offset != record.offset) {
+    // only retire the old record once the new one is written
+    page_id_t dead = INVALID_PAGE_ID;
+    file->io.seekp(old_record.offset);
+    file->io.write(reinterpret_cast<char *>(&dead), sizeof(dead));
+    file->free_records.emplace(old_record.capacity, old_record.offset);
+  }
+  // check for I/O error
+  if (file->io.bad()) {
+    LOG_DEBUG("I/O error while writing");
+    return;
+  }
+  file->file_size =
+      std::max(file->file_size, record.offset + sizeof(RecordHeader) + length);
+  // needs to flush to keep disk file in sync
+  file->io.flush();
+}
+
+/**
+ * Private helper function to read and decompress the record of a page
+ * A page that was never written reads as zeros
+ */
+bool DiskManager::ReadCompressedPage(DataFile *file, page_id_t page_id,
+                                     char *page_data) {
+  size_t page_no = PageNo(page_id);
+  if (page_no >= file->page_records.size() ||
+      file->page_records[page_no].capacity == 0) {
+    LOG_DEBUG("I/O error while reading");
+    memset(page_data, 0, PAGE_SIZE);
+    return true;
+  }
+  const PageRecord &record = file->page_records[page_no];
+  assert(record.capacity <= PAGE_SIZE);
+  char buffer[sizeof(RecordHeader) + PAGE_SIZE];
+  RecordHeader *header = reinterpret_cast<RecordHeader *>(buffer);
+  char *payload = buffer + sizeof(RecordHeader);
+  file->io.seekp(record.offset);
+  file->io.read(buffer, sizeof(RecordHeader) + record.capacity);
+  int read_count = file->io.gcount();
+  file->io.clear();
+
+  bool valid = read_count >= static_cast<int>(sizeof(RecordHeader)) &&
+               header->page_id == page_id && header->length <= PAGE_SIZE &&
+               read_count >=
+                   static_cast<int>(sizeof(RecordHeader) + header->length);
+  if (valid && checksum_ && header->crc != Crc32c(payload, header->length)) {
+    num_checksum_failures_++;
+    valid = false;
+  }
+  if (valid) {
+    if (header->length == PAGE_SIZE) {
+      memcpy(page_data, payload, PAGE_SIZE);
+      return true;
+    }
+    if (Lz4Decompress(payload, header->length, page_data, PAGE_SIZE) ==
+        PAGE_SIZE)
+      return true;
+  }
+  LOG_DEBUG("corrupted record for page %d", page_id);
+  memset(page_data, 0, PAGE_SIZE);
+  return false;
+}
+
 /**
  * Private helper function to get disk file size
  */
-int DiskManager::GetFileSize(const std::string &file_name) {
+int64_t DiskManager::GetFileSize(const std::string &file_name) {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
   return rc == 0 ? stat_buf.st_size : -1;
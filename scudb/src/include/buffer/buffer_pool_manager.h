@@ -4,11 +4,15 @@
  * Functionality: The simplified Buffer Manager interface allows a client to
  * new/delete pages on disk, to read a disk page into the buffer pool and pin
  * it, also to unpin a page in the buffer pool.
+ * If the disk manager maps the file read-only, pages are views into the mmap'ed database
+ * file: nothing is copied or evicted and pin counts are kept only for
+ * compatibility with the read/write interface.
  */
 
 #pragma once
 #include <list>
 #include <mutex>
+#include <vector>
 
 #include "buffer/lru_replacer.h"
 #include "disk/disk_manager.h"
@@ -30,9 +34,15 @@ public:
 
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  void FlushAllPages();
+
+  Page *NewPage(page_id_t &page_id, int file_id = 0);
 
   bool DeletePage(page_id_t page_id);
+
+  int CreateFile();
+
+  bool DropFile(int file_id);
   //added
     int GetPagePinCount(const page_id_t &page_id);
 
@@ -43,12 +53,15 @@ public:
 private:
   size_t pool_size_; // buffer pool中存放的页的总数
   Page *pages_;      // 存放页面的数组
+  char *frames_;     // memory backing pages_
   DiskManager *disk_manager_;
   LogManager *log_manager_;
   HashTable<page_id_t, Page *> *page_table_; // to keep track of pages
   Replacer<Page *> *replacer_;   // to find an unpinned page for replacement
   std::list<Page *> *free_list_; // to find a free page for replacement
   std::mutex latch_;             // to protect shared data structure
+  std::vector<Page *> mapped_pages_; // page views created in read-only mode
   Page* findTargetPage();
+  Page *FetchMappedPage(page_id_t page_id);
 };
 } // namespace scudb
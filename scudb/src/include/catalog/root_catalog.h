@@ -0,0 +1,53 @@
+/**
+ * root_catalog.h
+ *
+ * In-memory copy of the header page records: table/index name -> root page
+ * id. Records are read from the header page once, lookups never touch it
+ * again and changes are written through, so the header page (page 0) is only
+ * fetched when a root actually moves. The latch also keeps root changes of
+ * different indexes from writing the header page at the same time.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+class HeaderPage;
+
+class RootCatalog {
+public:
+  explicit RootCatalog(BufferPoolManager *buffer_pool_manager)
+      : buffer_pool_manager_(buffer_pool_manager) {}
+
+  // return false if there is no record of name
+  bool GetRootId(const std::string &name, page_id_t &root_id);
+
+  // insert or update the record of name, return false if the header page
+  // could not take the record (it is left as it was)
+  bool SetRootId(const std::string &name, page_id_t root_id);
+
+  // return false if the header page can't take that many new records
+  bool HasRoom(size_t records);
+
+  // return false if there is no record of name
+  bool DeleteRecord(const std::string &name);
+
+private:
+  // read the header page records on first use, the header page may not
+  // exist yet when the catalog is created
+  void Load();
+  HeaderPage *FetchHeaderPage();
+
+  BufferPoolManager *buffer_pool_manager_;
+  std::mutex latch_;
+  bool loaded_ = false;
+  std::unordered_map<std::string, page_id_t> root_ids_;
+};
+
+} // namespace scudb
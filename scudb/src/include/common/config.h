@@ -14,13 +14,19 @@ namespace scudb {
 
 extern std::chrono::duration<long long int> LOG_TIMEOUT;
 
+// period of the B+ tree background compaction, see BPlusTree::Compact
+extern std::chrono::duration<long long int> COMPACTION_TIMEOUT;
+
 extern std::atomic<bool> ENABLE_LOGGING;
 
 #define INVALID_PAGE_ID -1 // representing an invalid page id
 #define INVALID_TXN_ID -1  // representing an invalid txn id
 #define INVALID_LSN -1     // representing an invalid lsn
 #define HEADER_PAGE_ID 0   // the header page id
+#define FILE_ID_SHIFT 23   // page id = file id << FILE_ID_SHIFT | page in file
+#define MAX_FILE_ID 255    // largest data file id of a tablespace
 #define PAGE_SIZE 512     // size of a data page in byte
+#define CHECKSUM_SIZE 4   // size of the on-disk page checksum trailer in byte
 #define LOG_BUFFER_SIZE                                                            \
   ((BUFFER_POOL_SIZE + 1) * PAGE_SIZE) // size of a log buffer in byte
 #define BUCKET_SIZE 50                 // size of extendible hash bucket
@@ -0,0 +1,19 @@
+/**
+ * crc32c.h
+ *
+ * CRC-32C (Castagnoli) checksum, used to stamp and verify page trailers.
+ * Computed with the SSE4.2 crc32 instruction when the compiler targets it,
+ * otherwise with a table driven software fallback.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace scudb {
+
+// extend crc with len bytes of data, pass 0 to start a new checksum
+uint32_t Crc32c(const char *data, size_t len, uint32_t crc = 0);
+
+} // namespace scudb
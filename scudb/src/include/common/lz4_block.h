@@ -0,0 +1,19 @@
+/**
+ * lz4_block.h
+ *
+ * Small self-contained compressor producing the LZ4 block format (readable by
+ * LZ4_decompress_safe), tuned for page sized inputs: match offsets never
+ * exceed 64KB so a single hash table pass over the input is enough.
+ */
+
+#pragma once
+
+namespace scudb {
+
+// return compressed size, 0 if the result does not fit in dst_capacity
+int Lz4Compress(const char *src, int src_len, char *dst, int dst_capacity);
+
+// return decompressed size, -1 if src is malformed or overflows dst_capacity
+int Lz4Decompress(const char *src, int src_len, char *dst, int dst_capacity);
+
+} // namespace scudb
@@ -21,6 +21,9 @@ public:
   Transaction *Begin();
   void Commit(Transaction *txn);
   void Abort(Transaction *txn);
+  // undo the writes of txn after its first write_count ones, it keeps its
+  // locks and stays open
+  void RollbackTo(Transaction *txn, size_t write_count);
 
 private:
   std::atomic<txn_id_t> next_txn_id_;
@@ -5,49 +5,123 @@
  * database. It also performs read and write of pages to and from disk, and
  * provides a logical file layer within the context of a database management
  * system.
+ * A database is a tablespace of several data files: file 0 is the db file
+ * itself, further files (e.g. one per table) are named <db>_<file id>.<ext>.
+ * The high bits of a page id select the file (see FILE_ID_SHIFT).
+ * When opened read-only, the data files are mmap'ed and pages are handed out
+ * as views into the mapping instead of being copied into buffer frames.
+ * With checksums enabled every page is stored with a CRC32C trailer
+ * (CHECKSUM_SIZE bytes after the PAGE_SIZE data) which is verified on read, so
+ * torn writes and bit flips are rejected instead of returned as page content.
+ * In compressed mode pages are LZ4 compressed into variable sized records and
+ * an in-memory map from page id to record location is rebuilt from the record
+ * headers when the file is opened.
  */
 
 #pragma once
 #include <atomic>
 #include <fstream>
 #include <future>
+#include <map>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 
 namespace scudb {
 
+// location of a page inside a compressed data file
+struct PageRecord {
+  size_t offset = 0;     // start of record header
+  uint16_t capacity = 0; // payload bytes reserved, 0 means not stored yet
+  uint32_t seq = 0;      // write sequence number of the record
+};
+
+// one data file of the tablespace
+struct DataFile {
+  std::string name;
+  std::fstream io;
+  std::atomic<page_id_t> next_page_id{0}; // page number within this file
+  size_t file_size = 0; // bytes, tracked on write instead of stat per read
+  // read-only mapping
+  char *mapped_data = nullptr;
+  size_t mapped_size = 0;
+  // compressed storage
+  std::vector<PageRecord> page_records; // indexed by page number
+  std::multimap<uint16_t, size_t> free_records; // capacity -> dead record
+  size_t end_offset = 0;                         // where new records go
+  uint32_t next_seq = 1;                         // next record sequence number
+};
+
 class DiskManager {
 public:
-  DiskManager(const std::string &db_file);
+  DiskManager(const std::string &db_file, bool read_only = false,
+              bool checksum = false, bool compressed = false);
   ~DiskManager();
 
   void WritePage(page_id_t page_id, const char *page_data);
-  void ReadPage(page_id_t page_id, char *page_data);
+  // return false if the stored page fails checksum verification
+  bool ReadPage(page_id_t page_id, char *page_data);
+
+  // read-only mode: return a pointer into the file mapping, nullptr if the
+  // page lies beyond the mapped file
+  char *GetMappedPage(page_id_t page_id);
+  inline bool IsReadOnly() const { return read_only_; }
+  inline bool HasChecksum() const { return checksum_; }
+  inline bool IsCompressed() const { return compressed_; }
+  // pages are served as mmap views (read-only, uncompressed files)
+  inline bool IsMapped() const { return read_only_ && !compressed_; }
+
+  // tablespace: add a data file and return its id (-1 on failure), or unlink
+  // one together with all of its pages. file 0 can not be dropped
+  int CreateFile();
+  bool DropFile(int file_id);
+  bool HasFile(int file_id) const;
+  static inline int GetFileId(page_id_t page_id) {
+    return page_id >> FILE_ID_SHIFT;
+  }
 
   void WriteLog(char *log_data, int size);
   bool ReadLog(char *log_data, int size, int offset);
 
-  page_id_t AllocatePage();
+  // return INVALID_PAGE_ID if the file does not exist or is full
+  page_id_t AllocatePage(int file_id = 0);
   void DeallocatePage(page_id_t page_id);
 
   int GetNumFlushes() const;
   bool GetFlushState() const;
+  int GetNumChecksumFailures() const;
   inline void SetFlushLogFuture(std::future<void> *f) { flush_log_f_ = f; }
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
 private:
-  int GetFileSize(const std::string &name);
+  int64_t GetFileSize(const std::string &name);
+  std::string GetDataFileName(int file_id);
+  DataFile *OpenDataFile(const std::string &name);
+  void CloseDataFile(DataFile *file);
+  DataFile *GetDataFile(page_id_t page_id);
+  bool VerifyChecksum(page_id_t page_id, const char *slot);
+  void LoadPageRecords(DataFile *file);
+  void WriteCompressedPage(DataFile *file, page_id_t page_id,
+                           const char *page_data);
+  bool ReadCompressedPage(DataFile *file, page_id_t page_id, char *page_data);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // data files, indexed by file id, nullptr if absent
+  std::vector<DataFile *> files_;
   std::string file_name_;
-  std::atomic<page_id_t> next_page_id_;
   int num_flushes_;
   bool flush_log_;
   std::future<void> *flush_log_f_;
+  // read-only mapping of data files
+  bool read_only_;
+  // page checksum trailer
+  bool checksum_;
+  size_t slot_size_; // bytes a page occupies on disk
+  std::atomic<int> num_checksum_failures_;
+  // compressed storage
+  bool compressed_;
 };
 
-} // namespace scudb
\ No newline at end of file
+} // namespace scudb
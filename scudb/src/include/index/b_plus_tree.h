@@ -3,32 +3,79 @@
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) We only support unique key, non-unique indexes make their keys unique
+ * by appending the rid (see BPlusTreeIndex)
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ * (5) Concurrent access by latch crabbing: a thread latches a child before it
+ * lets go of the parent, and writers keep the latches of every ancestor that
+ * might change (tracked in the transaction's page set) until they reach a
+ * node that is safe, i.e. can not split or underflow. The root page id is
+ * guarded by its own latch which sits in the page set as a nullptr entry.
+ * (6) Point lookups do not crab: every page carries a right link and a high
+ * key (B-link tree), so a reader holds a single latch and moves right when a
+ * concurrent split has moved its key. Merged pages are left behind empty, a
+ * reader that lands on one, or misses its key after keys were shifted left by
+ * a redistribution, falls back to crabbing.
+ * (7) Deletes are lazy: a page is merged only once a delete empties it, so
+ * delete-then-reinsert churn does not bounce between split and merge. Leaves
+ * left underfull are remembered and merged or evened out with a sibling by
+ * Compact, which a background thread may run periodically.
+ * (8) Appends skip the descent: the right-most leaf is remembered and a key
+ * at or beyond its first key goes straight into it when it has room, so
+ * monotonic (auto-increment, timestamp) keys do not crab through the root.
+ * It makes an append cheaper, not concurrent: every appender still takes the
+ * latch of that one leaf (and the buffer pool's mutex), so appends from more
+ * threads do not add up to more appends per second.
+ * (9) A tree made with own_file keeps its pages in a data file of its own,
+ * created when the tree gets its first page, so dropping the index drops the
+ * file. The header page record of such a tree while it is empty still tells
+ * the file: INVALID_PAGE_ID - file id (see UpdateRootPageId).
  */
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <queue>
+#include <set>
+#include <thread>
 #include <vector>
 
+#include "catalog/root_catalog.h"
 #include "concurrency/transaction.h"
+#include "index/index.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
 #include "page/b_plus_tree_leaf_page.h"
+#include "page/b_plus_tree_varlen_internal_page.h"
+#include "page/b_plus_tree_varlen_leaf_page.h"
 
 namespace scudb {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
+#define B_PLUS_TREE_INTERNAL_PAGE                                              \
+  BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>
+
+// what a descent is going to do to the leaf, decides which latches it keeps
+// COMPACT: restore the minimum occupancy of the pages a delete left underfull
+enum class OpType { READ = 0, INSERT, DELETE, COMPACT };
+
 // Main class providing the API for the Interactive B+ Tree.
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTree {
 public:
+  // root page id changes go to the header page through catalog, or straight
+  // to the header page without one. root_page_id is the header page record
   explicit BPlusTree(const std::string &name,
                            BufferPoolManager *buffer_pool_manager,
                            const KeyComparator &comparator,
-                           page_id_t root_page_id = INVALID_PAGE_ID);
+                           page_id_t root_page_id = INVALID_PAGE_ID,
+                           RootCatalog *catalog = nullptr,
+                           bool own_file = false);
+
+  ~BPlusTree();
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -40,10 +87,21 @@ public:
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
+  // build an empty tree bottom-up from items sorted by key, packing pages to
+  // fill_factor of their capacity
+  bool BulkLoad(const std::vector<MappingType> &items,
+                double fill_factor = 1.0);
+
   // return the value associated with a given key
   bool GetValue(const KeyType &key, std::vector<ValueType> &result,
                 Transaction *transaction = nullptr);
 
+  // look up a batch of keys in key order, reusing the leaf between adjacent
+  // keys. values are appended in key order, return the number of keys found
+  int GetValues(const std::vector<KeyType> &keys,
+                std::vector<ValueType> &result,
+                Transaction *transaction = nullptr);
+
   // index iterator
   INDEXITERATOR_TYPE Begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
@@ -51,6 +109,23 @@ public:
   // Print this B+ tree to stdout using a simple command-line
   std::string ToString(bool verbose = false);
 
+  // pages, entries and fill of every level, root first
+  std::vector<IndexStats::Level> GetLevelStats();
+  // the same, estimated from paths random descents. The first key of each
+  // leaf reached is appended to leaf_keys
+  std::vector<IndexStats::Level>
+  SampleLevelStats(int paths, std::vector<KeyType> &leaf_keys);
+
+  // merge or redistribute the leaves deletes left underfull since the last
+  // pass, return the number of pages freed
+  int Compact(Transaction *transaction = nullptr);
+  // spawn a separate thread that compacts every COMPACTION_TIMEOUT
+  void RunCompactionThread();
+  void StopCompactionThread();
+
+  // release all pages, a tree owning its data file simply drops the file
+  bool DeleteTree();
+
   // read data from file and insert one by one
   void InsertFromFile(const std::string &file_name,
                       Transaction *transaction = nullptr);
@@ -59,41 +134,80 @@ public:
   void RemoveFromFile(const std::string &file_name,
                       Transaction *transaction = nullptr);
   // expose for test purpose
+  // the leaf is returned pinned and read latched
   B_PLUS_TREE_LEAF_PAGE_TYPE *FindLeafPage(const KeyType &key,
                                            bool leftMost = false);
 
 private:
+  Page *FetchLeafPage(const KeyType &key, bool leftMost, OpType op,
+                      Transaction *transaction, bool optimistic = false);
+  Page *FetchLeafPageBLink(const KeyType &key);
+  template <typename N> bool IsSafe(N *node, OpType op);
+  template <typename N> bool IsUnderflow(N *node, OpType op);
+  void AddCompactionCandidate(page_id_t page_id);
+  void ReleasePageSet(Transaction *transaction, bool is_dirty);
+  Page *FetchPage(page_id_t page_id);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
   bool InsertIntoLeaf(const KeyType &key, const ValueType &value,
                       Transaction *transaction = nullptr);
 
+  bool InsertIntoRightLeaf(const KeyType &key, const ValueType &value,
+                           bool &inserted);
+  void RememberRightLeaf(const B_PLUS_TREE_LEAF_PAGE_TYPE *leaf);
+
   void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key,
                         BPlusTreePage *new_node,
                         Transaction *transaction = nullptr);
 
   template <typename N> N *Split(N *node);
+  B_PLUS_TREE_LEAF_PAGE_TYPE *SplitAppend(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf);
+
+  template <typename N, typename ItemType>
+  void BuildLevel(const ItemType *items, int count, double fill_factor,
+                  std::vector<std::pair<KeyType, page_id_t>> *parent_items);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr,
+                              OpType op = OpType::DELETE);
 
   template <typename N>
   bool Coalesce(
       N *&neighbor_node, N *&node,
       BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-      int index, Transaction *transaction = nullptr);
+      int index, Transaction *transaction = nullptr,
+      OpType op = OpType::DELETE);
 
   template <typename N> void Redistribute(N *neighbor_node, N *node, int index);
 
   bool AdjustRoot(BPlusTreePage *node);
 
   void UpdateRootPageId(int insert_record = false);
+  // pick the data file of the first page of an empty tree
+  void OpenFile();
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  std::atomic<page_id_t> root_page_id_;
+  std::mutex root_latch_;
+  // data file new pages are allocated in, -1 until a tree owning its file
+  // has one. only set under the root latch while the tree is empty
+  int file_id_;
+  // right-most leaf as last seen by an insert, only a hint
+  std::atomic<page_id_t> right_leaf_page_id_;
+  // bumped whenever a redistribution moves keys to the left sibling
+  std::atomic<uint64_t> left_shifts_;
   BufferPoolManager *buffer_pool_manager_;
+  RootCatalog *catalog_;
   KeyComparator comparator_;
+  // leaves left underfull by deletes, for the next compaction pass
+  std::set<page_id_t> underfull_pages_;
+  // protects underfull_pages_ and wakes the compaction thread
+  std::mutex compaction_latch_;
+  std::condition_variable compaction_cv_;
+  std::thread *compaction_thread_ = nullptr;
+  bool stop_compaction_ = false;
 };
 
 } // namespace scudb
@@ -4,41 +4,182 @@
 
 #pragma once
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "index/b_plus_tree.h"
+#include "index/bloom_filter.h"
 #include "index/index.h"
 
 namespace scudb {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+// range scan over the leaf chain, stops at the upper bound. Entries are
+// copied out a batch at a time and the leaf is released right away: the
+// caller (a SQLite cursor) may write to the tree between two steps, which
+// would wait forever on a latch the scan held. The next batch is looked up
+// again after the last key handed out, keys of the tree are unique. So is
+// the rest of the batch once an entry was deleted, it may be one of them.
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeIndexScan : public IndexScanIterator {
+public:
+  // iterator starts at the first key not less than low_key. key_schema
+  // decodes the tree keys, the rid column (if any) sits at rid_column
+  BPlusTreeIndexScan(BPlusTree<KeyType, ValueType, KeyComparator> *tree,
+                     const std::atomic<int64_t> *deletes,
+                     INDEXITERATOR_TYPE &&iterator,
+                     const KeyComparator &comparator, Schema *key_schema,
+                     int rid_column, const KeyType *low_key,
+                     bool low_inclusive, const KeyType *high_key,
+                     bool high_inclusive);
+
+  bool IsEnd() override { return offset_ == entries_.size(); }
+
+  RID GetRid() override { return entries_[offset_].second; }
+
+  Value GetKeyValue(int column) override {
+    // the included columns follow the rid
+    if (rid_column_ >= 0 && column >= rid_column_)
+      column++;
+    return entries_[offset_].first.ToValue(key_schema_, column);
+  }
+
+  void Next() override;
+
+private:
+  // copy up to SCAN_BATCH_SIZE entries within the bounds, then let go of
+  // the iterator and its leaf
+  void Fill(INDEXITERATOR_TYPE &iterator);
+
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_;
+  // deletes from the tree so far, and when the batch was copied
+  const std::atomic<int64_t> *deletes_;
+  int64_t batch_deletes_;
+  std::vector<std::pair<KeyType, ValueType>> entries_;
+  size_t offset_;
+  // no entries left after the current batch
+  bool done_;
+  KeyComparator comparator_;
+  Schema *key_schema_;
+  int rid_column_;
+  bool has_high_key_;
+  KeyType high_key_;
+  bool high_inclusive_;
+};
+
+/*
+ * The tree only holds unique keys. A non-unique index appends the rid to the
+ * indexed columns, so equal keys are kept in rid order and the entries of a
+ * key are found by a range scan. Included columns are stored after the rid,
+ * where they never decide the order; an index with included columns always
+ * appends the rid, a unique one checks for the key before inserting.
+ *
+ * With a filter, ScanKey, ScanKeys and ScanRange over a single key skip the
+ * keys a Bloom filter of the index keys rules out without touching a page.
+ * Inserts add to the filter, deletes leave it alone, it is built from the
+ * tree on open and again (at twice the size) once it holds as many keys as
+ * it was sized for.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
 
 public:
   BPlusTreeIndex(IndexMetadata *metadata,
                  BufferPoolManager *buffer_pool_manager,
-                 page_id_t root_page_id = INVALID_PAGE_ID);
+                 page_id_t root_page_id = INVALID_PAGE_ID,
+                 RootCatalog *catalog = nullptr, bool own_file = false);
 
-  ~BPlusTreeIndex() {}
+  ~BPlusTreeIndex() {
+    delete rid_key_schema_;
+    delete entry_key_schema_;
+  }
 
-  void InsertEntry(const Tuple &key, RID rid,
+  bool InsertEntry(const Tuple &key, RID rid,
                    Transaction *transaction = nullptr) override;
 
-  void DeleteEntry(const Tuple &key,
+  void InsertEntries(const std::vector<std::pair<Tuple, RID>> &entries,
+                     Transaction *transaction = nullptr) override;
+
+  void DeleteEntry(const Tuple &key, RID rid,
                    Transaction *transaction = nullptr) override;
 
+  bool FindKey(const Tuple &key, RID &rid,
+               Transaction *transaction = nullptr) override;
+
   void ScanKey(const Tuple &key, std::vector<RID> &result,
                Transaction *transaction = nullptr) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<RID> &result,
+                Transaction *transaction = nullptr) override;
+
+  bool BulkLoad(const std::vector<std::pair<Tuple, RID>> &entries,
+                double fill_factor = 1.0) override;
+
+  std::unique_ptr<IndexScanIterator>
+  ScanRange(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+            bool high_inclusive) override;
+
+  IndexStats GetStats(int buckets) override;
+
+  IndexStats EstimateStats(int paths) override;
+
+  FilterStats GetFilterStats() override;
+
+  int Compact() override;
+
+  bool DeleteIndex() override;
+
 protected:
+  // key of the tree for an index key, rid is ignored by a unique index
+  KeyType TreeKey(const Tuple &key, int64_t rid) const;
+  // key of the tree for an entry tuple, included columns and all
+  KeyType EntryKey(const Tuple &entry, int64_t rid) const;
+  // indexed columns of an entry tuple
+  Tuple KeyOf(const Tuple &entry) const;
+  // whether two tree keys hold the same index key, rids aside
+  bool SameIndexKey(const KeyType &lhs, const KeyType &rhs) const;
+  // the first rid stored under the index key of tree_key, a tree key with
+  // MIN_RID. the filter may answer, but this is none of the lookups its
+  // statistics count
+  bool FindIndexKey(const KeyType &tree_key, RID &rid);
+  // append the rids of all tree keys in [low, high]
+  void ScanTreeKeys(const KeyType &low, const KeyType &high,
+                    std::vector<RID> &result);
+  // whether the filter lets a tree key (its index key part) through
+  bool FilterMayContain(const KeyType &tree_key);
+  // a lookup of the key counted by the filter statistics, true if the filter
+  // rules the key out. false without a filter
+  bool FilterRulesOut(const KeyType &tree_key);
+  void AddToFilter(const KeyType &tree_key);
+  // replace the filter by one sized for capacity keys (or more, if the tree
+  // holds more) holding the keys of the tree
+  void RebuildFilter(int64_t capacity);
+
+  // key schema plus rid column, nullptr for a unique index without included
+  // columns
+  Schema *rid_key_schema_;
+  // rid key schema plus the included columns, nullptr without them
+  Schema *entry_key_schema_;
   // comparator for key
   KeyComparator comparator_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
+  // nullptr unless the metadata asks for a filter
+  std::unique_ptr<BloomFilter> filter_;
+  std::mutex filter_latch_;
+  // a RebuildFilter walks the tree, the keys added meanwhile
+  bool rebuilding_filter_ = false;
+  std::vector<KeyType> filter_added_keys_;
+  std::atomic<int64_t> filter_lookups_;
+  std::atomic<int64_t> filter_negatives_;
+  std::atomic<int64_t> filter_false_positives_;
+  // entries deleted, open range scans check it
+  std::atomic<int64_t> deletes_;
 };
 
 } // namespace scudb
@@ -0,0 +1,51 @@
+/**
+ * bloom_filter.h
+ *
+ * Bloom filter over byte strings: a lookup answers "maybe present" or
+ * "definitely absent". With BLOOM_FILTER_BITS_PER_KEY bits per key and
+ * BLOOM_FILTER_HASHES probes the false positive rate stays near 1% up to
+ * the capacity the filter was sized for. Keys can not be removed, a filter
+ * is built again to forget them.
+ *
+ * Not thread safe, the owner latches it.
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace scudb {
+
+const int BLOOM_FILTER_BITS_PER_KEY = 10;
+const int BLOOM_FILTER_HASHES = 7;
+
+class BloomFilter {
+public:
+  explicit BloomFilter(int64_t capacity = 0) { Reset(capacity); }
+
+  // drop every key and size the filter for capacity keys
+  void Reset(int64_t capacity);
+
+  void Add(const char *data, int size);
+
+  // false if the key was never added
+  bool MayContain(const char *data, int size) const;
+
+  // keys added since the last reset
+  inline int64_t GetKeyCount() const { return keys_; }
+
+  inline int64_t GetCapacity() const { return capacity_; }
+
+  inline int64_t GetBitCount() const {
+    return static_cast<int64_t>(words_.size()) * 64;
+  }
+
+private:
+  static uint64_t Hash(const char *data, int size);
+
+  std::vector<uint64_t> words_;
+  int64_t capacity_ = 0;
+  int64_t keys_ = 0;
+};
+
+} // namespace scudb
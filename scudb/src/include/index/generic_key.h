@@ -5,52 +5,50 @@
  *
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
- * with a template argument.
+ * with a template argument. The key tuple is stored memcomparable (see
+ * key_encoder.h), so keys are ordered with a plain memcmp.
  */
 #pragma once
 
+#include <algorithm>
 #include <cstring>
 
+#include "index/key_encoder.h"
 #include "table/tuple.h"
-#include "type/value.h"
 
 namespace scudb {
 template <size_t KeySize> class GenericKey {
 public:
-  inline void SetFromKey(const Tuple &tuple) {
+  inline void SetFromKey(const Tuple &tuple, Schema *key_schema) {
     // intialize to 0
     memset(data, 0, KeySize);
-    memcpy(data, tuple.GetData(), tuple.GetLength());
+    KeyEncoder::Encode(tuple, key_schema, data, KeySize);
+  }
+
+  // value of an indexed column, for index-only scans
+  inline Value ToValue(Schema *key_schema, int column) const {
+    return KeyEncoder::Decode(data, key_schema, column);
   }
 
   // NOTE: for test purpose only
+  // encode key as a single BIGINT column
   inline void SetFromInteger(int64_t key) {
+    char bigint[sizeof(int64_t)];
+    KeyEncoder::EncodeBigint(key, bigint);
     memset(data, 0, KeySize);
-    memcpy(data, &key, sizeof(int64_t));
-  }
-
-  inline Value ToValue(Schema *schema, int column_id) const {
-    const char *data_ptr;
-    const TypeId column_type = schema->GetType(column_id);
-    const bool is_inlined = schema->IsInlined(column_id);
-    if (is_inlined) {
-      data_ptr = (data + schema->GetOffset(column_id));
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(
-          const_cast<char *>(data + schema->GetOffset(column_id)));
-      data_ptr = (data + offset);
-    }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    memcpy(data, bigint, std::min(KeySize, sizeof(int64_t)));
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // decode the first 8 bytes as a BIGINT
   inline int64_t ToString() const {
-    return *reinterpret_cast<int64_t *>(const_cast<char *>(data));
+    char bigint[sizeof(int64_t)] = {};
+    memcpy(bigint, data, std::min(KeySize, sizeof(int64_t)));
+    return KeyEncoder::DecodeBigint(bigint);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // decode the first 8 bytes as a BIGINT
   friend std::ostream &operator<<(std::ostream &os, const GenericKey &key) {
     os << key.ToString();
     return os;
@@ -67,31 +65,11 @@ template <size_t KeySize> class GenericComparator {
 public:
   inline int operator()(const GenericKey<KeySize> &lhs,
                         const GenericKey<KeySize> &rhs) const {
-    int column_count = key_schema_->GetColumnCount();
-
-    for (int i = 0; i < column_count; i++) {
-      Value lhs_value = (lhs.ToValue(key_schema_, i));
-      Value rhs_value = (rhs.ToValue(key_schema_, i));
-
-      if (lhs_value.CompareLessThan(rhs_value) == CMP_TRUE)
-        return -1;
-
-      if (lhs_value.CompareGreaterThan(rhs_value) == CMP_TRUE)
-        return 1;
-    }
-    // equals
-    return 0;
+    return memcmp(lhs.data, rhs.data, KeySize);
   }
 
-  GenericComparator(const GenericComparator &other) {
-    this->key_schema_ = other.key_schema_;
-  }
-
-  // constructor
-  GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
-
-private:
-  Schema *key_schema_;
+  // the encoded keys order themselves, the key schema is not needed
+  GenericComparator(Schema *) {}
 };
 
 } // namespace scudb
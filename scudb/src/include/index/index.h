@@ -6,6 +6,7 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "catalog/schema.h"
@@ -28,12 +29,24 @@ class IndexMetadata {
 
 public:
   IndexMetadata(std::string index_name, std::string table_name,
-                const Schema *tuple_schema, const std::vector<int> &key_attrs)
-      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs) {
+                const Schema *tuple_schema, const std::vector<int> &key_attrs,
+                bool is_unique = false,
+                const std::vector<int> &include_attrs = {},
+                bool has_filter = false)
+      : name_(index_name), table_name_(table_name), key_attrs_(key_attrs),
+        include_attrs_(include_attrs), is_unique_(is_unique),
+        has_filter_(has_filter) {
     key_schema_ = Schema::CopySchema(tuple_schema, key_attrs_);
+    std::vector<int> entry_attrs(key_attrs_);
+    entry_attrs.insert(entry_attrs.end(), include_attrs_.begin(),
+                       include_attrs_.end());
+    entry_schema_ = Schema::CopySchema(tuple_schema, entry_attrs);
   }
 
-  ~IndexMetadata() { delete key_schema_; };
+  ~IndexMetadata() {
+    delete key_schema_;
+    delete entry_schema_;
+  };
 
   inline const std::string &GetName() const { return name_; }
 
@@ -51,6 +64,21 @@ public:
   //  columns
   inline const std::vector<int> &GetKeyAttrs() const { return key_attrs_; }
 
+  // base table columns stored with every entry in the leaves, not searchable
+  inline const std::vector<int> &GetIncludeAttrs() const {
+    return include_attrs_;
+  }
+
+  // schema of the tuples an index is maintained with: the indexed columns
+  // followed by the included columns
+  inline Schema *GetEntrySchema() const { return entry_schema_; }
+
+  // a unique index keeps one rid per key, otherwise every rid is indexed
+  inline bool IsUnique() const { return is_unique_; }
+
+  // point lookups check a Bloom filter of the keys before the index
+  inline bool HasFilter() const { return has_filter_; }
+
   // Get a string representation for debugging
   const std::string ToString() const {
     std::stringstream os;
@@ -58,6 +86,9 @@ public:
     os << "IndexMetadata["
        << "Name = " << name_ << ", "
        << "Type = B+Tree, "
+       << "Unique = " << is_unique_ << ", "
+       << "Included columns = " << include_attrs_.size() << ", "
+       << "Filter = " << has_filter_ << ", "
        << "Table name = " << table_name_ << "] :: ";
     os << key_schema_->ToString();
 
@@ -69,8 +100,83 @@ private:
   std::string table_name_;
   // The mapping relation between key schema and tuple schema
   const std::vector<int> key_attrs_;
+  const std::vector<int> include_attrs_;
   // schema of the indexed key
   Schema *key_schema_;
+  // schema of the indexed key plus the included columns
+  Schema *entry_schema_;
+  bool is_unique_;
+  bool has_filter_;
+};
+
+/**
+ * class IndexScanIterator - Streams the rids of an index range scan in key
+ * order. No page stays pinned or latched between calls, so the table may be
+ * written while a scan is open.
+ */
+class IndexScanIterator {
+public:
+  virtual ~IndexScanIterator() {}
+
+  virtual bool IsEnd() = 0;
+
+  // rid of the current entry, only valid while !IsEnd()
+  virtual RID GetRid() = 0;
+
+  // column of the index entry schema (key columns, then included columns)
+  // of the current entry, read from the index. Only valid while !IsEnd()
+  virtual Value GetKeyValue(int column) = 0;
+
+  virtual void Next() = 0;
+};
+
+/**
+ * class IndexStats - Shape and key distribution of an index, a snapshot
+ * taken by walking the whole index
+ */
+struct IndexStats {
+  // one per level, from the root down to the leaves
+  struct Level {
+    int pages;
+    int64_t entries;
+    // average fraction of a page in use
+    double fill_factor;
+  };
+  // equi-depth histogram bucket, ends at (and includes) the entry of
+  // upper_bound
+  struct Bucket {
+    RID upper_bound;
+    int64_t entries;
+    int64_t distinct_keys;
+  };
+
+  int GetHeight() const { return static_cast<int>(levels.size()); }
+
+  std::vector<Level> levels;
+  std::vector<Bucket> histogram;
+  int64_t entries = 0;
+  int64_t distinct_keys = 0;
+};
+
+/**
+ * struct FilterStats - Size of the key filter of an index and how it did on
+ * the point lookups since the index was opened
+ */
+struct FilterStats {
+  // a lookup passing the filter that finds nothing is a false positive
+  double GetFalsePositiveRate() const {
+    int64_t absent = negatives + false_positives;
+    return absent == 0 ? 0 : static_cast<double>(false_positives) / absent;
+  }
+
+  // 0 if the index has no filter
+  int64_t bits = 0;
+  // keys added since the filter was last built
+  int64_t keys = 0;
+  int64_t lookups = 0;
+  // lookups answered by the filter alone
+  int64_t negatives = 0;
+  int64_t false_positives = 0;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -106,10 +212,16 @@ public:
 
   Schema *GetKeySchema() const { return metadata_->GetKeySchema(); }
 
+  Schema *GetEntrySchema() const { return metadata_->GetEntrySchema(); }
+
   const std::vector<int> &GetKeyAttrs() const {
     return metadata_->GetKeyAttrs();
   }
 
+  const std::vector<int> &GetIncludeAttrs() const {
+    return metadata_->GetIncludeAttrs();
+  }
+
   // Get a string representation for debugging
   const std::string ToString() const {
     std::stringstream os;
@@ -122,17 +234,74 @@ public:
   ///////////////////////////////////////////////////////////////////
   // Point Modification
   ///////////////////////////////////////////////////////////////////
-  // designed for secondary indexes.
-  virtual void InsertEntry(const Tuple &key, RID rid,
+  // designed for secondary indexes. The key tuples given to InsertEntry,
+  // DeleteEntry and BulkLoad follow the entry schema, those of the scans the
+  // key schema
+  // return false if a unique index holds the key already, the entry is left
+  // out then
+  virtual bool InsertEntry(const Tuple &key, RID rid,
                            Transaction *transaction = nullptr) = 0;
 
+  // batched InsertEntry for the rows of a multi-row insert, same result as
+  // inserting the entries one by one in the order given
+  virtual void InsertEntries(const std::vector<std::pair<Tuple, RID>> &entries,
+                             Transaction *transaction = nullptr) = 0;
+
   // delete the index entry linked to given tuple
-  virtual void DeleteEntry(const Tuple &key,
+  virtual void DeleteEntry(const Tuple &key, RID rid,
                            Transaction *transaction = nullptr) = 0;
 
+  // a rid stored under key, for the key check of a unique index before a
+  // row is written. not counted as a lookup by the filter statistics
+  virtual bool FindKey(const Tuple &key, RID &rid,
+                       Transaction *transaction = nullptr) = 0;
+
+  // every rid stored under key, more than one unless the index is unique
   virtual void ScanKey(const Tuple &key, std::vector<RID> &result,
                        Transaction *transaction = nullptr) = 0;
 
+  // batched ScanKey for IN lists and join probes, rids come in key order
+  virtual void ScanKeys(const std::vector<Tuple> &keys,
+                        std::vector<RID> &result,
+                        Transaction *transaction = nullptr) = 0;
+
+  // build an empty index from (key tuple, rid) entries in any order, pages
+  // are packed to fill_factor. a unique index keeps the first rid of a key.
+  // return false if the index is not empty
+  virtual bool BulkLoad(const std::vector<std::pair<Tuple, RID>> &entries,
+                        double fill_factor = 1.0) = 0;
+
+  ///////////////////////////////////////////////////////////////////
+  // Range Scan
+  ///////////////////////////////////////////////////////////////////
+  // scan keys between low_key and high_key in key order, a nullptr bound is
+  // open ended
+  virtual std::unique_ptr<IndexScanIterator>
+  ScanRange(const Tuple *low_key, bool low_inclusive, const Tuple *high_key,
+            bool high_inclusive) = 0;
+
+  ///////////////////////////////////////////////////////////////////
+  // Statistics
+  ///////////////////////////////////////////////////////////////////
+  // walk the index, with a histogram of at most buckets buckets
+  virtual IndexStats GetStats(int buckets) = 0;
+
+  // estimate the shape, entry and distinct key counts from paths random
+  // root-to-leaf descents, without a histogram
+  virtual IndexStats EstimateStats(int paths) = 0;
+
+  // counters of the key filter, kept up to date by the lookups
+  virtual FilterStats GetFilterStats() = 0;
+
+  ///////////////////////////////////////////////////////////////////
+  // Maintenance
+  ///////////////////////////////////////////////////////////////////
+  // give back the room deletes left unused, return the number of pages freed
+  virtual int Compact() = 0;
+
+  // release all pages of a dropped index, return false if that failed
+  virtual bool DeleteIndex() = 0;
+
 private:
   //===--------------------------------------------------------------------===//
   //  Data members
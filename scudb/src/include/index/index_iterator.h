@@ -1,9 +1,15 @@
 /**
  * index_iterator.h
  * For range scan of b+ tree
+ * The iterator keeps the current leaf pinned and read latched. When stepping
+ * to the right sibling it pins the sibling before giving up the current leaf,
+ * and only then latches it, so it never waits for a latch while holding one.
  */
 #pragma once
+#include <utility>
+
 #include "page/b_plus_tree_leaf_page.h"
+#include "page/b_plus_tree_varlen_leaf_page.h"
 
 namespace scudb {
 
@@ -13,18 +19,32 @@ namespace scudb {
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
 public:
-  // you may define your own constructor based on your member variables
-  IndexIterator();
+  // leaf page is pinned and read latched by the caller, nullptr for an empty
+  // scan
+  IndexIterator(Page *page, int index,
+                BufferPoolManager *buffer_pool_manager);
+  IndexIterator(IndexIterator &&other);
+  IndexIterator(const IndexIterator &) = delete;
+  IndexIterator &operator=(const IndexIterator &) = delete;
   ~IndexIterator();
 
   bool isEnd();
 
-  const MappingType &operator*();
+  // a reference into the leaf, or a copy if the leaf does not store pairs
+  auto operator*()
+      -> decltype(std::declval<B_PLUS_TREE_LEAF_PAGE_TYPE &>().GetItem(0));
 
   IndexIterator &operator++();
 
 private:
-  // add your own private member variables here
+  // skip to the next leaf with entries once index runs off the current one
+  void SkipExhaustedLeaves();
+  void ReleaseLeaf();
+
+  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf_;
+  Page *page_;
+  int index_;
+  BufferPoolManager *buffer_pool_manager_;
 };
 
 } // namespace scudb
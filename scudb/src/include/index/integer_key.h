@@ -0,0 +1,96 @@
+/**
+ * integer_key.h
+ *
+ * Key used for indexing a single INTEGER or BIGINT column
+ *
+ * The key holds the raw key tuple: the column value (4 bytes for INTEGER, 8
+ * for BIGINT) in native byte order, followed by the rid for a non-unique
+ * index. IntegerComparator reads them as native integers, so comparisons on
+ * the search path are a couple of loads and compares the compiler can
+ * inline.
+ */
+#pragma once
+
+#include <cstring>
+#include <type_traits>
+
+#include "table/tuple.h"
+
+namespace scudb {
+template <size_t KeySize> class IntegerKey {
+  static_assert(KeySize == 4 || KeySize == 8 || KeySize == 12 || KeySize == 16,
+                "an integer key is an INTEGER or BIGINT, optionally + rid");
+
+public:
+  // native type of the column value
+  typedef typename std::conditional<KeySize % 8 == 4, int32_t, int64_t>::type
+      IntType;
+  static constexpr bool HAS_RID = KeySize > sizeof(int64_t);
+
+  inline void SetFromKey(const Tuple &tuple, Schema * /* Unused */) {
+    // intialize to 0
+    memset(data, 0, KeySize);
+    memcpy(data, tuple.GetData(), tuple.GetLength());
+  }
+
+  // NOTE: for test purpose only
+  inline void SetFromInteger(int64_t key) {
+    memset(data, 0, KeySize);
+    IntType value = static_cast<IntType>(key);
+    memcpy(data, &value, sizeof(IntType));
+  }
+
+  inline IntType GetInteger() const {
+    IntType value;
+    memcpy(&value, data, sizeof(IntType));
+    return value;
+  }
+
+  // value of the indexed column, for index-only scans
+  inline Value ToValue(Schema *key_schema, int /* Unused */) const {
+    return Value(key_schema->GetType(0), GetInteger());
+  }
+
+  inline int64_t GetRid() const {
+    int64_t rid = 0;
+    if (HAS_RID)
+      memcpy(&rid, data + sizeof(IntType), sizeof(int64_t));
+    return rid;
+  }
+
+  // NOTE: for test purpose only
+  inline int64_t ToString() const { return GetInteger(); }
+
+  // NOTE: for test purpose only
+  friend std::ostream &operator<<(std::ostream &os, const IntegerKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  char data[KeySize];
+};
+
+/**
+ * Function object returns true if lhs < rhs, used for trees
+ */
+template <size_t KeySize> class IntegerComparator {
+public:
+  inline int operator()(const IntegerKey<KeySize> &lhs,
+                        const IntegerKey<KeySize> &rhs) const {
+    auto lhs_value = lhs.GetInteger(), rhs_value = rhs.GetInteger();
+    if (lhs_value != rhs_value)
+      return lhs_value < rhs_value ? -1 : 1;
+    if (IntegerKey<KeySize>::HAS_RID) {
+      int64_t lhs_rid = lhs.GetRid(), rhs_rid = rhs.GetRid();
+      if (lhs_rid != rhs_rid)
+        return lhs_rid < rhs_rid ? -1 : 1;
+    }
+    // equals
+    return 0;
+  }
+
+  // the key schema is implied by the key size
+  IntegerComparator(Schema *) {}
+};
+
+} // namespace scudb
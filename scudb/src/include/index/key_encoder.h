@@ -0,0 +1,61 @@
+/**
+ * key_encoder.h
+ *
+ * Order preserving (memcomparable) encoding of key tuples
+ *
+ * Two encoded keys compare with memcmp the way their tuples compare column
+ * by column, so index keys need no schema to be ordered:
+ *  - integers are stored big endian with the sign bit flipped
+ *  - a DECIMAL has its sign bit flipped if positive and all its bits flipped
+ *    if negative, then is stored big endian
+ *  - a TIMESTAMP (unsigned) is stored big endian
+ *  - a VARCHAR has each 0x00 byte escaped as 0x00 0xFF and ends with
+ *    0x00 0x01, so a string sorts before its extensions. NULL is 0x00 0x00
+ * Every column delimits itself, an encoded key is never a proper prefix of
+ * another key of the same schema.
+ */
+#pragma once
+
+#include <cstdint>
+
+#include "catalog/schema.h"
+#include "table/tuple.h"
+
+namespace scudb {
+
+class KeyEncoder {
+public:
+  /*
+   * Encode key into at most size bytes of data and return the bytes used.
+   * VARCHAR values of a key that does not fit are cut to an equal share of
+   * the room the fixed length columns leave, the key then holds a prefix of
+   * them which keeps the order of keys, but not their distinctness
+   */
+  static int Encode(const Tuple &key, Schema *schema, char *data, int size);
+
+  // value of column of an encoded key. A VARCHAR value cut short by Encode
+  // comes back as its prefix
+  static Value Decode(const char *data, Schema *schema, int column);
+
+  // bytes taken by an encoded key of schema, e.g. the leading columns of a
+  // longer key
+  static int Length(const char *data, Schema *schema);
+
+  // encoded size of a key with VARCHAR values at their declared length
+  static int MaxLength(Schema *schema);
+
+  // encoding of a single BIGINT
+  static void EncodeBigint(int64_t value, char *data);
+  static int64_t DecodeBigint(const char *data);
+
+private:
+  // big endian store of the low size bytes of bits
+  static void StoreBigEndian(uint64_t bits, int size, char *data);
+  static uint64_t LoadBigEndian(const char *data, int size);
+  static int EncodeVarchar(const Value &value, char *data, int size);
+  static Value DecodeVarchar(const char *data);
+  // bytes of an encoded VARCHAR, terminator included
+  static int VarcharLength(const char *data);
+};
+
+} // namespace scudb
@@ -0,0 +1,114 @@
+/**
+ * varlen_key.h
+ *
+ * Key used for indexing keys with VARCHAR columns
+ *
+ * Like GenericKey this key holds a memcomparable encoded key tuple, but it
+ * also records how many bytes of it are used. B+ tree pages for this key type
+ * (see b_plus_tree_varlen_page.h) store only those bytes instead of a fixed
+ * size slot, so short keys pack densely. A key takes at most VARLEN_KEY_SIZE
+ * bytes, longer VARCHAR values are cut to fit.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "common/config.h"
+#include "index/key_encoder.h"
+#include "table/tuple.h"
+
+namespace scudb {
+
+// largest serialized key, small enough that a page always splits into two
+// halves that take another key
+static constexpr int VARLEN_KEY_SIZE = PAGE_SIZE / 8;
+
+class VarlenKey {
+public:
+  inline void SetFromKey(const Tuple &tuple, Schema *key_schema) {
+    size_ = KeyEncoder::Encode(tuple, key_schema, data, VARLEN_KEY_SIZE);
+  }
+
+  // value of an indexed column, for index-only scans
+  inline Value ToValue(Schema *key_schema, int column) const {
+    return KeyEncoder::Decode(data, key_schema, column);
+  }
+
+  inline void SetFromBytes(const char *bytes, int size) {
+    assert(size >= 0 && size <= VARLEN_KEY_SIZE);
+    size_ = size;
+    memcpy(data, bytes, size);
+  }
+
+  // NOTE: for test purpose only
+  // encode key as a single BIGINT column
+  inline void SetFromInteger(int64_t key) {
+    size_ = sizeof(int64_t);
+    KeyEncoder::EncodeBigint(key, data);
+  }
+
+  inline int GetSize() const { return size_; }
+
+  // NOTE: for test purpose only
+  // decode the first 8 bytes as a BIGINT
+  inline int64_t ToString() const {
+    char bigint[sizeof(int64_t)] = {};
+    memcpy(bigint, data, size_ < 8 ? size_ : 8);
+    return KeyEncoder::DecodeBigint(bigint);
+  }
+
+  // NOTE: for test purpose only
+  friend std::ostream &operator<<(std::ostream &os, const VarlenKey &key) {
+    os << key.ToString();
+    return os;
+  }
+
+  char data[VARLEN_KEY_SIZE];
+
+private:
+  uint16_t size_ = 0;
+};
+
+/**
+ * Function object comparing two encoded keys bytewise, a key sorts before
+ * its extensions
+ */
+class VarlenComparator {
+public:
+  inline int operator()(const VarlenKey &lhs, const VarlenKey &rhs) const {
+    return Compare(lhs.data, lhs.GetSize(), rhs.data, rhs.GetSize());
+  }
+
+  // keys are compared where they are stored, pages do not copy them out
+  inline int Compare(const char *lhs, int lhs_size, const char *rhs,
+                     int rhs_size) const {
+    int cmp = memcmp(lhs, rhs, lhs_size < rhs_size ? lhs_size : rhs_size);
+    if (cmp != 0)
+      return cmp;
+    return lhs_size - rhs_size;
+  }
+
+  // the encoded keys order themselves, the key schema is not needed
+  VarlenComparator(Schema *) {}
+};
+
+/**
+ * Shortest prefix of right that still sorts after left, given left < right.
+ * A leaf split hands it up as the separator instead of all of right (suffix
+ * truncation), so internal pages keep only the bytes that tell the two
+ * leaves apart and fit more children.
+ */
+inline VarlenKey ShortestSeparator(const VarlenKey &left,
+                                   const VarlenKey &right) {
+  int common = 0;
+  while (common < left.GetSize() && common < right.GetSize() &&
+         left.data[common] == right.data[common])
+    common++;
+  VarlenKey separator;
+  separator.SetFromBytes(right.data, std::min(common + 1, right.GetSize()));
+  return separator;
+}
+
+} // namespace scudb
@@ -12,10 +12,15 @@
  *  --------------------------------------------------------------------------
  * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
  *  --------------------------------------------------------------------------
+ * The header is followed by the page id of the right sibling on the same
+ * level and the high key, the separator between this page and that sibling
+ * (meaningless when there is no right sibling). Together they let a reader
+ * that arrives after a concurrent split move right (B-link tree).
  */
 
 #pragma once
 
+#include <algorithm>
 #include <queue>
 
 #include "page/b_plus_tree_page.h"
@@ -33,10 +38,20 @@ public:
 
   KeyType KeyAt(int index) const;
   void SetKeyAt(int index, const KeyType &key);
+  // keys have a fixed size, so a key always fits in place of another
+  bool CanSetKeyAt(int, const KeyType &) const { return true; }
   int ValueIndex(const ValueType &value) const;
   ValueType ValueAt(int index) const;
 
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+
+  // right link and high key
+  page_id_t GetNextPageId() const;
+  void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+  bool IsBeyondHighKey(const KeyType &key,
+                       const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
                        const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
@@ -44,6 +59,9 @@ public:
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
+  // append sorted items and adopt their children, used by bulk loading
+  void CopyNFrom(const MappingType *items, int size,
+                 BufferPoolManager *buffer_pool_manager);
   void MoveHalfTo(BPlusTreeInternalPage *recipient,
                   BufferPoolManager *buffer_pool_manager);
   void MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
@@ -67,6 +85,10 @@ private:
                     BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, int parent_index,
                      BufferPoolManager *buffer_pool_manager);
+  BPlusTreeInternalPage *FetchParent(BufferPoolManager *buffer_pool_manager);
+  void AdoptChild(page_id_t child_id, BufferPoolManager *buffer_pool_manager);
+  page_id_t next_page_id_;
+  KeyType high_key_;
   MappingType array[0];
 };
 } // namespace scudb
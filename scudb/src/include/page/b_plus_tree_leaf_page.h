@@ -10,15 +10,21 @@
  * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 24 bytes in total):
+ *  Header format (size in byte, 28 bytes plus the high key in total):
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
+ *  --------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | HighKey (KeySize) |
+ *  --------------------------------------------------------------------
+ * HighKey is padded to the alignment of KeyType, so it starts at byte 32
+ * for 64-bit integer keys.
+ * HighKey separates this page from the next one and is meaningless on the
+ * last leaf. A reader looking for a key at or beyond it, because a concurrent
+ * split moved the key away, follows NextPageId (B-link tree).
  */
 #pragma once
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -38,6 +44,10 @@ public:
   // helper methods
   page_id_t GetNextPageId() const;
   void SetNextPageId(page_id_t next_page_id);
+  KeyType GetHighKey() const;
+  void SetHighKey(const KeyType &key);
+  bool IsBeyondHighKey(const KeyType &key,
+                       const KeyComparator &comparator) const;
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
   const MappingType &GetItem(int index);
@@ -49,9 +59,14 @@ public:
               const KeyComparator &comparator) const;
   int RemoveAndDeleteRecord(const KeyType &key,
                             const KeyComparator &comparator);
+  // append sorted items, used by bulk loading
+  void CopyNFrom(const MappingType *items, int size,
+                 BufferPoolManager * /* Unused */);
   // Split and Merge utility methods
   void MoveHalfTo(BPlusTreeLeafPage *recipient,
                   BufferPoolManager *buffer_pool_manager /* Unused */);
+  void MoveLastTo(BPlusTreeLeafPage *recipient,
+                  BufferPoolManager *buffer_pool_manager /* Unused */);
   void MoveAllTo(BPlusTreeLeafPage *recipient, int /* Unused */,
                  BufferPoolManager * /* Unused */);
   void MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
@@ -68,6 +83,7 @@ private:
   void CopyFirstFrom(const MappingType &item, int parentIndex,
                      BufferPoolManager *buffer_pool_manager);
   page_id_t next_page_id_;
+  KeyType high_key_;
   MappingType array[0];
 };
 } // namespace scudb
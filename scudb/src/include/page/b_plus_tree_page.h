@@ -6,7 +6,7 @@
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 20 bytes in total):
+ * Header format (size in byte, 24 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
@@ -23,6 +23,7 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "index/generic_key.h"
+#include "index/integer_key.h"
 
 namespace scudb {
 
@@ -49,6 +50,29 @@ public:
   void SetMaxSize(int max_size);
   int GetMinSize() const;
 
+  // occupancy checks used by the tree, counted in entries. Pages with entries
+  // of variable size (see b_plus_tree_varlen_page.h) count bytes instead
+  bool IsOverflow() const;
+  bool IsUnderflow() const;
+  bool IsSafeToInsert() const;
+  bool IsSafeToRemove() const;
+  bool CanMergeWith(const BPlusTreePage *sibling) const;
+  // deletes only restructure a page once it holds no key: a leaf without
+  // entries, an internal page down to a single child (the rule of the root).
+  // Pages they leave underfull wait for BPlusTree::Compact
+  bool IsEmpty() const;
+  bool IsSafeToRemoveLazily() const;
+  // IsUnderflow of a non-root page. Does not read the parent page id, which
+  // a merge may be rewriting without holding this page's latch
+  bool IsBelowMinSize() const;
+  // room for entries when bulk loading, in units of ItemSize
+  int GetCapacity() const;
+  // fraction of the page in use
+  double GetFillFactor() const;
+  template <typename ItemType> static int ItemSize(const ItemType &) {
+    return 1;
+  }
+
   page_id_t GetParentPageId() const;
   void SetParentPageId(page_id_t parent_page_id);
 
@@ -0,0 +1,69 @@
+/**
+ * b_plus_tree_varlen_internal_page.h
+ *
+ * Internal page for variable length keys. Same interface as
+ * BPlusTreeInternalPage, but entries are kept in the slot directory and key
+ * heap of BPlusTreeVarlenPage: a cell holds the key bytes followed by the
+ * child page id. The first key is invalid as usual, it is stored empty
+ * unless a split or merge needs it.
+ */
+#pragma once
+
+#include <queue>
+#include <string>
+
+#include "page/b_plus_tree_internal_page.h"
+#include "page/b_plus_tree_varlen_page.h"
+
+namespace scudb {
+
+#define B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE                                  \
+  BPlusTreeInternalPage<VarlenKey, page_id_t, VarlenComparator>
+
+template <>
+class BPlusTreeInternalPage<VarlenKey, page_id_t, VarlenComparator>
+    : public BPlusTreeVarlenPage<page_id_t> {
+  typedef VarlenKey KeyType;
+  typedef page_id_t ValueType;
+  typedef VarlenComparator KeyComparator;
+
+public:
+  // must call initialize method after "create" a new node
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+
+  void SetKeyAt(int index, const KeyType &key);
+  int ValueIndex(const ValueType &value) const;
+
+  ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
+
+  void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
+                       const ValueType &new_value);
+  int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
+                      const ValueType &new_value);
+  void Remove(int index);
+  ValueType RemoveAndReturnOnlyChild();
+
+  // append sorted items and adopt their children, used by bulk loading
+  void CopyNFrom(const MappingType *items, int size,
+                 BufferPoolManager *buffer_pool_manager);
+  void MoveHalfTo(BPlusTreeInternalPage *recipient,
+                  BufferPoolManager *buffer_pool_manager);
+  void MoveAllTo(BPlusTreeInternalPage *recipient, int index_in_parent,
+                 BufferPoolManager *buffer_pool_manager);
+  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient,
+                        BufferPoolManager *buffer_pool_manager);
+  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, int parent_index,
+                         BufferPoolManager *buffer_pool_manager);
+  // DEUBG and PRINT
+  std::string ToString(bool verbose) const;
+  void QueueUpChildren(std::queue<BPlusTreePage *> *queue,
+                       BufferPoolManager *buffer_pool_manager);
+
+private:
+  void CopyFirstFrom(const MappingType &pair, int parent_index,
+                     BufferPoolManager *buffer_pool_manager);
+  BPlusTreeInternalPage *FetchParent(BufferPoolManager *buffer_pool_manager);
+  void AdoptChild(page_id_t child_id, BufferPoolManager *buffer_pool_manager);
+};
+
+} // namespace scudb
@@ -0,0 +1,67 @@
+/**
+ * b_plus_tree_varlen_leaf_page.h
+ *
+ * Leaf page for variable length keys. Same interface as BPlusTreeLeafPage, so
+ * BPlusTree works on it unchanged, but entries are kept in the slot directory
+ * and key heap of BPlusTreeVarlenPage: a cell holds the key bytes followed by
+ * the RID. Entries are handed out by value since they are not stored as
+ * pairs.
+ */
+#pragma once
+
+#include <string>
+
+#include "common/rid.h"
+#include "page/b_plus_tree_leaf_page.h"
+#include "page/b_plus_tree_varlen_page.h"
+
+namespace scudb {
+
+#define B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE                                      \
+  BPlusTreeLeafPage<VarlenKey, RID, VarlenComparator>
+
+template <>
+class BPlusTreeLeafPage<VarlenKey, RID, VarlenComparator>
+    : public BPlusTreeVarlenPage<RID> {
+  typedef VarlenKey KeyType;
+  typedef RID ValueType;
+  typedef VarlenComparator KeyComparator;
+
+public:
+  // After creating a new leaf page from buffer pool, must call initialize
+  // method to set default values
+  void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID);
+  // helper methods
+  int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
+  MappingType GetItem(int index) const;
+
+  // insert and delete methods
+  int Insert(const KeyType &key, const ValueType &value,
+             const KeyComparator &comparator);
+  bool Lookup(const KeyType &key, ValueType &value,
+              const KeyComparator &comparator) const;
+  int RemoveAndDeleteRecord(const KeyType &key,
+                            const KeyComparator &comparator);
+  // append sorted items, used by bulk loading
+  void CopyNFrom(const MappingType *items, int size,
+                 BufferPoolManager * /* Unused */);
+  // Split and Merge utility methods
+  void MoveHalfTo(BPlusTreeLeafPage *recipient,
+                  BufferPoolManager * /* Unused */);
+  void MoveLastTo(BPlusTreeLeafPage *recipient,
+                  BufferPoolManager * /* Unused */);
+  void MoveAllTo(BPlusTreeLeafPage *recipient, int /* Unused */,
+                 BufferPoolManager * /* Unused */);
+  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient,
+                        BufferPoolManager *buffer_pool_manager);
+  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient, int parentIndex,
+                         BufferPoolManager *buffer_pool_manager);
+  // Debug
+  std::string ToString(bool verbose = false) const;
+
+private:
+  void CopyFirstFrom(const MappingType &item, int parentIndex,
+                     BufferPoolManager *buffer_pool_manager);
+};
+
+} // namespace scudb
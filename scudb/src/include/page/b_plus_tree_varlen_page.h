@@ -0,0 +1,119 @@
+/**
+ * b_plus_tree_varlen_page.h
+ *
+ * Common part of leaf and internal pages for variable length keys (see
+ * index/varlen_key.h). Entries do not have a fixed size, so instead of an
+ * array of pairs the page keeps a slot directory in the style of TablePage:
+ * slots are kept in key order right after the header, each one points at a
+ * cell (key bytes followed by the value) in the key heap, which grows from
+ * the end of the page towards the slots. The high key lives in the heap as
+ * well. Freed cells are compacted right away, so the free space between
+ * slots and heap stays contiguous.
+ *
+ * Page format:
+ *  ----------------------------------------------------------------------
+ * | HEADER | SLOT(1) | ... | SLOT(n) | ... FREE SPACE ... | CELLS + HIGH |
+ *  ----------------------------------------------------------------------
+ *                                                         ^
+ *                                                 free space pointer
+ *
+ *  Header format (size in byte, 36 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | NextPageId (4) | FreeSpacePointer (2) |
+ *  ---------------------------------------------------------------------
+ *  --------------------------------------------
+ * | HighKeyOffset (2) | HighKeySize (2) | (2) |
+ *  --------------------------------------------
+ *  Slot format: | CellOffset (2) | KeySize (2) |
+ *
+ * Occupancy is counted in bytes of slots, cells and high key. MaxSize holds
+ * the capacity, the page keeps room for one more entry beyond it so an entry
+ * can go in before the page is split.
+ */
+#pragma once
+
+#include <utility>
+
+#include "index/varlen_key.h"
+#include "page/b_plus_tree_page.h"
+
+namespace scudb {
+
+template <typename ValueType> class BPlusTreeVarlenPage : public BPlusTreePage {
+public:
+  // initialize the slot directory and key heap of a new page
+  void InitHeap();
+
+  // right link and high key
+  page_id_t GetNextPageId() const { return next_page_id_; }
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+  VarlenKey GetHighKey() const;
+  void SetHighKey(const VarlenKey &key);
+  bool IsBeyondHighKey(const VarlenKey &key,
+                       const VarlenComparator &comparator) const;
+
+  VarlenKey KeyAt(int index) const;
+  ValueType ValueAt(int index) const;
+
+  // occupancy checks of the tree, in bytes
+  bool IsOverflow() const;
+  bool IsUnderflow() const;
+  bool IsSafeToInsert() const;
+  bool IsSafeToRemove() const;
+  bool IsBelowMinSize() const;
+  bool CanMergeWith(const BPlusTreeVarlenPage *sibling) const;
+  bool CanSetKeyAt(int index, const VarlenKey &key) const;
+  // room for entries when bulk loading, the high key is set aside
+  int GetCapacity() const;
+  double GetFillFactor() const;
+  static int ItemSize(const std::pair<VarlenKey, ValueType> &item);
+
+protected:
+  struct Slot {
+    uint16_t offset;
+    uint16_t key_size;
+  };
+  static constexpr int MAX_ENTRY_SIZE =
+      sizeof(Slot) + VARLEN_KEY_SIZE + sizeof(ValueType);
+
+  const char *KeyData(int index) const {
+    return reinterpret_cast<const char *>(this) + slots_[index].offset;
+  }
+  // compare the key at index, in place, with key
+  int CompareKeyAt(int index, const VarlenKey &key,
+                   const VarlenComparator &comparator) const {
+    return comparator.Compare(KeyData(index), slots_[index].key_size,
+                              key.data, key.GetSize());
+  }
+  void InsertCell(int index, const char *key, int key_size,
+                  const ValueType &value);
+  void InsertCell(int index, const VarlenKey &key, const ValueType &value) {
+    InsertCell(index, key.data, key.GetSize(), value);
+  }
+  void RemoveCell(int index);
+  void ReplaceKey(int index, const VarlenKey &key);
+  // remove the entries from index on
+  void Truncate(int index);
+  // first entry of the right half when splitting by bytes
+  int SplitIndex() const;
+
+private:
+  int GetUsedBytes() const;
+  int GetFreeBytes() const;
+  // store bytes in the key heap, return their offset
+  uint16_t Allocate(const char *bytes, int size);
+  // release bytes of the key heap and close the gap
+  void Release(uint16_t offset, int size);
+
+  page_id_t next_page_id_;
+  uint16_t free_space_pointer_;
+  uint16_t high_key_offset_;
+  uint16_t high_key_size_;
+  uint16_t padding_;
+  Slot slots_[0];
+};
+
+} // namespace scudb
@@ -0,0 +1,45 @@
+/**
+ * free_space_page.h
+ *
+ * Page of the free space map of a table heap, holding the free bytes of heap
+ * pages in the order the pages joined the heap. The pages of a map form a
+ * singly linked list, each of them full but the last one.
+ *
+ * Format (size in byte):
+ *  -------------------------------------------------------
+ * | NextPageId (4) | EntryCount (4) | Entry_1 page_id (4) |
+ *  -------------------------------------------------------
+ *  ----------------------------------------------------
+ * | Entry_1 free bytes (4) | Entry_2 page_id (4) | ... |
+ *  ----------------------------------------------------
+ */
+
+#pragma once
+
+#include <cstring>
+
+#include "page/page.h"
+
+namespace scudb {
+
+class FreeSpacePage : public Page {
+public:
+  static const int MAX_ENTRY_COUNT = (PAGE_SIZE - 8) / 8;
+
+  void Init() {
+    SetNextPageId(INVALID_PAGE_ID);
+    SetEntryCount(0);
+  }
+
+  page_id_t GetNextPageId();
+  void SetNextPageId(page_id_t next_page_id);
+  int GetEntryCount();
+
+  void GetEntry(int index, page_id_t &page_id, int32_t &free_bytes);
+  // index may be the entry count, which appends an entry
+  void SetEntry(int index, page_id_t page_id, int32_t free_bytes);
+
+private:
+  void SetEntryCount(int entry_count);
+};
+} // namespace scudb
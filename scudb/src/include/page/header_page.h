@@ -21,10 +21,14 @@ namespace scudb {
 
 class HeaderPage : public Page {
 public:
+  // number of records that fit the page
+  static constexpr int MAX_RECORD_COUNT = (PAGE_SIZE - 4) / 36;
+
   void Init() { SetRecordCount(0); }
   /**
    * Record related
    */
+  // return false if the name is taken or too long, or the page is full
   bool InsertRecord(const std::string &name, const page_id_t root_id);
   bool DeleteRecord(const std::string &name);
   bool UpdateRecord(const std::string &name, const page_id_t root_id);
@@ -32,6 +36,8 @@ public:
   // return root_id if success
   bool GetRootId(const std::string &name, page_id_t &root_id);
   int GetRecordCount();
+  // name and root_id of the record at index, for loading every record
+  void GetRecord(int index, std::string &name, page_id_t &root_id);
 
 private:
   /**
@@ -16,6 +16,8 @@
  * | TupleCount (4) | Tuple_1 offset (4) | Tuple_1 size (4) | ... |
  *  --------------------------------------------------------------
  *
+ * The first page of a table heap has no previous page, its PrevPageId holds
+ * the first page of the free space map of the heap instead.
  */
 
 #pragma once
@@ -42,6 +44,9 @@ public:
   page_id_t GetNextPageId();
   void SetPrevPageId(page_id_t prev_page_id);
   void SetNextPageId(page_id_t next_page_id);
+  // first page of a table heap only
+  page_id_t GetFreeSpacePageId();
+  void SetFreeSpacePageId(page_id_t free_space_page_id);
 
   /**
    * Tuple related
@@ -71,6 +76,10 @@ public:
   bool GetFirstTupleRid(RID &first_rid);
   bool GetNextTupleRid(const RID &cur_rid, RID &next_rid);
 
+  // size of the largest tuple InsertTuple takes: the free bytes, less the 8
+  // of a new slot unless a slot emptied by a delete can be reused
+  int32_t GetInsertSpaceSize();
+
 private:
   /**
    * helper functions
@@ -0,0 +1,76 @@
+/**
+ * free_space_map.h
+ *
+ * Free bytes of every page of a table heap, so that an insert goes straight
+ * to a page with room instead of walking the page chain. The free bytes of a
+ * page are the size of the largest tuple it takes (see
+ * TablePage::GetInsertSpaceSize), slots emptied by deletes included. The
+ * map is kept in memory and written through to its own pages (see
+ * free_space_page.h), in the data file of the heap.
+ *
+ * The figures are hints: a page may hold less room than the map says, e.g.
+ * after a crash, and the map is corrected when an insert finds out. Heap
+ * pages the stored map misses are found by following the chain from the
+ * last page it knows.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace scudb {
+
+class FreeSpaceMap {
+public:
+  // first_page_id: first page of the stored map, a new map is allocated next
+  // to the heap if it is INVALID_PAGE_ID. the map is only kept in memory if
+  // that fails, e.g. on a read-only database
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager,
+               page_id_t first_heap_page_id, page_id_t first_page_id);
+
+  // a heap page with at least size free bytes, INVALID_PAGE_ID if there is
+  // none. the fullest of them is chosen
+  page_id_t FindPage(int size);
+
+  // record the free bytes of a heap page, a page new to the map is the last
+  // page of the heap
+  void Update(page_id_t page_id, int32_t free_bytes);
+
+  page_id_t GetLastHeapPageId();
+
+  // INVALID_PAGE_ID if the map is only kept in memory
+  inline page_id_t GetFirstPageId() const { return first_page_id_; }
+
+  // release the pages of the stored map
+  bool DeletePages();
+
+private:
+  // read the stored map and the heap pages it misses, on first use
+  void Load();
+  void Track(page_id_t page_id, int32_t free_bytes);
+  // write the entry of a heap page to the stored map
+  void Store(int slot, page_id_t page_id, int32_t free_bytes);
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_heap_page_id_;
+  page_id_t last_heap_page_id_;
+  page_id_t first_page_id_;
+  std::mutex latch_;
+  bool loaded_ = false;
+  // pages of the stored map, in list order
+  std::vector<page_id_t> page_ids_;
+  // entries of the stored map, the first slots of heap_pages_
+  int stored_entries_ = 0;
+  // heap page -> (free bytes, slot of its entry)
+  std::unordered_map<page_id_t, std::pair<int32_t, int>> heap_pages_;
+  // (free bytes, heap page), ordered by room
+  std::set<std::pair<int32_t, page_id_t>> by_free_bytes_;
+};
+
+} // namespace scudb
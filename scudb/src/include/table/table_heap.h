@@ -6,9 +6,12 @@
 
 #pragma once
 
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "logging/log_manager.h"
 #include "page/table_page.h"
+#include "table/free_space_map.h"
 #include "table/table_iterator.h"
 #include "table/tuple.h"
 
@@ -18,19 +21,26 @@ class TableHeap {
   friend class TableIterator;
 
 public:
-  ~TableHeap() {}
+  ~TableHeap() { delete free_space_map_; }
 
-  // open a table heap
+  // open a table heap, its first page tells the first page of its free space
+  // map (a new map is built from the pages if there is none)
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager,
             LogManager *log_manager, page_id_t first_page_id);
 
-  // create table heap
+  // create table heap, all of its pages are allocated in data file file_id
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager,
-            LogManager *log_manager, Transaction *txn);
+            LogManager *log_manager, Transaction *txn, int file_id = 0);
 
   // for insert, if tuple is too large (>~page_size), return false
   bool InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn);
 
+  // insert tuples in order, rids[i] is the rid of tuples[i] or an invalid
+  // RID if it was not inserted (too large, out of memory). return false if
+  // any was not
+  bool InsertTuples(const std::vector<Tuple> &tuples, std::vector<RID> &rids,
+                    Transaction *txn);
+
   bool MarkDelete(const RID &rid, Transaction *txn); // for delete
 
   // if the new tuple is too large to fit in the old page, return false (will
@@ -44,6 +54,7 @@ public:
 
   bool GetTuple(const RID &rid, Tuple &tuple, Transaction *txn);
 
+  // release all pages, a heap owning its data file simply drops the file
   bool DeleteTableHeap();
 
   TableIterator begin(Transaction *txn);
@@ -52,6 +63,11 @@ public:
 
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  // INVALID_PAGE_ID if the free space map is only kept in memory
+  inline page_id_t GetFreeSpacePageId() const {
+    return free_space_map_->GetFirstPageId();
+  }
+
 private:
   /**
    * Members
@@ -60,6 +76,8 @@ private:
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_;
+  // inserts go to a page it knows to have room, else to a new last page
+  FreeSpaceMap *free_space_map_;
 };
 
 } // namespace scudb
@@ -4,7 +4,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <map>
+#include <unordered_set>
+#include <vector>
+
 #include "buffer/lru_replacer.h"
+#include "catalog/root_catalog.h"
 #include "catalog/schema.h"
 #include "concurrency/transaction_manager.h"
 #include "index/b_plus_tree_index.h"
@@ -24,9 +32,13 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
 
 Tuple ConstructTuple(Schema *schema, sqlite3_value **argv);
 
+// own_file: pages of the index go to a data file of its own
 Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
-                      page_id_t root_id = INVALID_PAGE_ID);
+                      page_id_t root_id = INVALID_PAGE_ID,
+                      RootCatalog *catalog = nullptr, bool own_file = false);
+// whether long VARCHAR values are indexed by a prefix of them only
+bool HasPrefixKeys(IndexMetadata *metadata);
 Transaction *GetTransaction();
 
 /* API declaration */
@@ -40,6 +52,8 @@ int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo);
 
 int VtabDisconnect(sqlite3_vtab *pVtab);
 
+int VtabDestroy(sqlite3_vtab *pVtab);
+
 int VtabOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor);
 
 int VtabClose(sqlite3_vtab_cursor *cur);
@@ -59,20 +73,77 @@ int VtabCommit(sqlite3_vtab *pVTab);
 
 int VtabBegin(sqlite3_vtab *pVTab);
 
+int VtabRollback(sqlite3_vtab *pVTab);
+
+int VtabSavepoint(sqlite3_vtab *pVTab, int savepoint);
+
+int VtabRelease(sqlite3_vtab *pVTab, int savepoint);
+
+int VtabRollbackTo(sqlite3_vtab *pVTab, int savepoint);
+
+/* Index statistics table-valued functions */
+int StatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                 sqlite3_vtab **ppVtab, char **pzErr);
+
+int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo);
+
+int StatsDisconnect(sqlite3_vtab *pVtab);
+
+int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor);
+
+int StatsClose(sqlite3_vtab_cursor *cur);
+
+int StatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                const char *idxStr, int argc, sqlite3_value **argv);
+
+int StatsNext(sqlite3_vtab_cursor *cur);
+
+int StatsEof(sqlite3_vtab_cursor *cur);
+
+int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i);
+
+int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid);
+
+// idxNum of an index scan, as chosen by VtabBestIndex for VtabFilter
+const int INDEX_SCAN_EQ = 1;        // point query on every indexed column
+const int INDEX_SCAN_RANGE = 2;     // ordered scan over the index
+const int INDEX_SCAN_LOW = 4;       // lower bound given (first argv)
+const int INDEX_SCAN_LOW_OPEN = 8;  // lower bound excluded
+const int INDEX_SCAN_HIGH = 16;     // upper bound given (next argv)
+const int INDEX_SCAN_HIGH_OPEN = 32; // upper bound excluded
+const int INDEX_SCAN_COVERING = 64;  // columns read are indexed, no heap fetch
+
+// buckets of the key histogram index_histogram shows
+const int STATS_HISTOGRAM_BUCKETS = 16;
+// root-to-leaf descents the planner statistics are estimated from
+const int STATS_SAMPLE_PATHS = 8;
+// pAux of the statistics functions, the rows they return
+const int STATS_LEVELS = 0;    // index_stats: one per level of the tree
+const int STATS_HISTOGRAM = 1; // index_histogram: one per bucket
+const int STATS_FILTER = 2;    // index_filter: one if the index has a filter
+// hidden column taking the table name, the argument of every function
+const int STATS_TABLE_NAME_COLUMN = 4;
+
+// rows an insert keeps back before writing them to the heap and index
+const size_t INSERT_BATCH_SIZE = 512;
+
 // storage engine
+// read_only: serve pages straight from a mmap of db file (no writes allowed)
 class StorageEngine {
 public:
-  StorageEngine(std::string db_file_name) {
+  StorageEngine(std::string db_file_name, bool read_only = false) {
     ENABLE_LOGGING = false;
 
     // storage related
-    disk_manager_ = new DiskManager(db_file_name);
+    disk_manager_ = new DiskManager(db_file_name, read_only);
 
     // log related
     log_manager_ = new LogManager(disk_manager_);
 
     buffer_pool_manager_ =
         new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager_, log_manager_);
+    // root page ids of tables and indexes, cached from the header page
+    catalog_ = new RootCatalog(buffer_pool_manager_);
 
     // txn related
     lock_manager_ = new LockManager(true); // S2PL
@@ -82,6 +153,8 @@ public:
   ~StorageEngine() {
     if (ENABLE_LOGGING)
       log_manager_->StopFlushThread();
+    buffer_pool_manager_->FlushAllPages();
+    delete catalog_;
     delete disk_manager_;
     delete buffer_pool_manager_;
     delete log_manager_;
@@ -89,8 +162,11 @@ public:
     delete transaction_manager_;
   }
 
+  inline bool IsReadOnly() { return disk_manager_->IsReadOnly(); }
+
   DiskManager *disk_manager_;
   BufferPoolManager *buffer_pool_manager_;
+  RootCatalog *catalog_;
   LockManager *lock_manager_;
   TransactionManager *transaction_manager_;
   LogManager *log_manager_;
@@ -99,15 +175,22 @@ public:
 StorageEngine *storage_engine_;
 // global transaction, sqlite does not support concurrent transaction
 Transaction *global_transaction_ = nullptr;
+// transaction and size of its write set at each open savepoint
+std::vector<std::pair<txn_id_t, size_t>> savepoints_;
+class VirtualTable;
+// tables connected to sqlite by name, for the statistics functions
+std::map<std::string, VirtualTable *> virtual_tables_;
 
 class VirtualTable {
   friend class Cursor;
 
 public:
-  VirtualTable(Schema *schema, BufferPoolManager *buffer_pool_manager,
+  // file_id: data file a new table heap is created in
+  VirtualTable(const std::string &name, Schema *schema,
+               BufferPoolManager *buffer_pool_manager,
                LockManager *lock_manager, LogManager *log_manager, Index *index,
-               page_id_t first_page_id = INVALID_PAGE_ID)
-      : schema_(schema), index_(index) {
+               page_id_t first_page_id = INVALID_PAGE_ID, int file_id = 0)
+      : name_(name), schema_(schema), index_(index) {
     if (first_page_id != INVALID_PAGE_ID) {
       // reopen an exist table
       table_heap_ = new TableHeap(buffer_pool_manager, lock_manager,
@@ -115,34 +198,130 @@ public:
     } else {
       // create table for the first time
       Transaction *txn = storage_engine_->transaction_manager_->Begin();
-      table_heap_ =
-          new TableHeap(buffer_pool_manager, lock_manager, log_manager, txn);
+      table_heap_ = new TableHeap(buffer_pool_manager, lock_manager,
+                                  log_manager, txn, file_id);
       storage_engine_->transaction_manager_->Commit(txn);
     }
+    virtual_tables_[name_] = this;
   }
 
   ~VirtualTable() {
+    // sqlite commits or rolls back before a table is disconnected, rows still
+    // held back belong to neither and are dropped, not written
+    DiscardInserts();
+    virtual_tables_.erase(name_);
     delete schema_;
     delete table_heap_;
     delete index_;
   }
 
+  // insert a row of the current transaction, written with the rows after it
+  // once INSERT_BATCH_SIZE are held back, or when FlushInserts is called. A
+  // row of a table with a unique index is checked and written at once,
+  // return false if another row holds its key
+  inline bool BufferInsert(const Tuple &tuple) {
+    if (index_ != nullptr && index_->GetMetadata()->IsUnique()) {
+      RID rid;
+      if (HasKeyConflict(tuple, rid))
+        return false;
+      if (InsertTuple(tuple, rid))
+        InsertEntry(tuple, rid);
+      return true;
+    }
+    pending_.push_back(tuple);
+    if (pending_.size() >= INSERT_BATCH_SIZE)
+      FlushInserts();
+    return true;
+  }
+
+  // write the rows held back, one latch per heap page and the index entries
+  // in key order. called before anything reads the table and at commit
+  inline void FlushInserts() {
+    if (pending_.empty())
+      return;
+    std::vector<RID> rids;
+    table_heap_->InsertTuples(pending_, rids, GetTransaction());
+    if (index_ != nullptr) {
+      std::vector<std::pair<Tuple, RID>> entries;
+      for (size_t i = 0; i < pending_.size(); i++)
+        if (rids[i].GetPageId() != INVALID_PAGE_ID)
+          entries.emplace_back(EntryOf(pending_[i]), rids[i]);
+      index_->InsertEntries(entries, GetTransaction());
+      CountEntries(entries.size());
+    }
+    pending_.clear();
+  }
+
+  // drop the rows held back, when their transaction or savepoint is rolled
+  // back. They were never written
+  inline void DiscardInserts() { pending_.clear(); }
+
+  // a rollback of the table heap leaves the index alone: take out the
+  // entries of the rows as writes left them, before they are undone
+  inline void DeleteWrittenEntries(const std::deque<WriteRecord> &writes) {
+    if (index_ == nullptr)
+      return;
+    for (auto &write : writes) {
+      Tuple tuple(write.rid_);
+      if (write.table_ == table_heap_ && write.wtype_ != WType::DELETE &&
+          table_heap_->GetTuple(write.rid_, tuple, GetTransaction())) {
+        index_->DeleteEntry(EntryOf(tuple), write.rid_, GetTransaction());
+        CountEntries(-1);
+      }
+    }
+  }
+
+  // and put back the entries of the rows the undo restored
+  inline void RestoreEntries(const std::deque<WriteRecord> &writes) {
+    if (index_ == nullptr)
+      return;
+    std::unordered_set<RID> restored;
+    for (auto &write : writes) {
+      Tuple tuple(write.rid_);
+      if (write.table_ == table_heap_ && write.wtype_ != WType::INSERT &&
+          restored.insert(write.rid_).second &&
+          table_heap_->GetTuple(write.rid_, tuple, GetTransaction()))
+        InsertEntry(tuple, write.rid_);
+    }
+  }
+
   // insert into table heap
   inline bool InsertTuple(const Tuple &tuple, RID &rid) {
     return table_heap_->InsertTuple(tuple, rid, GetTransaction());
   }
 
-  // insert into index
-  inline void InsertEntry(const Tuple &tuple, const RID &rid) {
+  // insert into index, false if a unique index holds the key already
+  inline bool InsertEntry(const Tuple &tuple, const RID &rid) {
     if (index_ == nullptr)
-      return;
-    // construct indexed key tuple
-    std::vector<Value> key_values;
+      return true;
+    if (!index_->InsertEntry(EntryOf(tuple), rid, GetTransaction()))
+      return false;
+    CountEntries(1);
+    return true;
+  }
 
-    for (auto &i : index_->GetKeyAttrs())
-      key_values.push_back(tuple.GetValue(schema_, i));
-    Tuple key(key_values, index_->GetKeySchema());
-    index_->InsertEntry(key, rid, GetTransaction());
+  // whether a row other than the one at rid holds the key of tuple in a
+  // unique index
+  inline bool HasKeyConflict(const Tuple &tuple, const RID &rid) {
+    if (index_ == nullptr || !index_->GetMetadata()->IsUnique())
+      return false;
+    RID found;
+    return index_->FindKey(KeyOf(tuple), found, GetTransaction()) &&
+           !(found == rid);
+  }
+
+  // fill an empty index from the tuples already in the table heap, keys are
+  // sorted in memory and the tree is built bottom-up
+  inline void BuildIndex() {
+    if (index_ == nullptr)
+      return;
+    Transaction *txn = storage_engine_->transaction_manager_->Begin();
+    std::vector<std::pair<Tuple, RID>> entries;
+    for (auto it = table_heap_->begin(txn); it != table_heap_->end(); ++it)
+      entries.emplace_back(EntryOf(*it), it->GetRid());
+    index_->BulkLoad(entries);
+    storage_engine_->transaction_manager_->Commit(txn);
+    has_stats_ = false;
   }
 
   // delete from table heap
@@ -157,13 +336,8 @@ public:
       return;
     Tuple deleted_tuple(rid);
     table_heap_->GetTuple(rid, deleted_tuple, GetTransaction());
-    // construct indexed key tuple
-    std::vector<Value> key_values;
-
-    for (auto &i : index_->GetKeyAttrs())
-      key_values.push_back(deleted_tuple.GetValue(schema_, i));
-    Tuple key(key_values, index_->GetKeySchema());
-    index_->DeleteEntry(key, GetTransaction());
+    index_->DeleteEntry(EntryOf(deleted_tuple), rid, GetTransaction());
+    CountEntries(-1);
   }
 
   // update table heap tuple
@@ -176,6 +350,8 @@ public:
 
   inline TableIterator end() { return table_heap_->end(); }
 
+  inline const std::string &GetName() { return name_; }
+
   inline Schema *GetSchema() { return schema_; }
 
   inline Index *GetIndex() { return index_; }
@@ -184,14 +360,101 @@ public:
 
   inline page_id_t GetFirstPageId() { return table_heap_->GetFirstPageId(); }
 
+  // statistics of the index for the planner, estimated from a sample of the
+  // index on first use and kept up to date by the writes after that
+  inline const IndexStats &GetIndexStats() {
+    if (!has_stats_)
+      SetIndexStats(index_->EstimateStats(STATS_SAMPLE_PATHS));
+    return stats_;
+  }
+
+  // statistics from a walk of the whole index, for index_stats and
+  // index_histogram. The planner uses them from then on
+  inline const IndexStats &RefreshIndexStats() {
+    SetIndexStats(index_->GetStats(STATS_HISTOGRAM_BUCKETS));
+    return stats_;
+  }
+
+  // count index entries a write added, or took out when count is negative.
+  // Distinct keys and leaf pages keep their ratio to the entries, an empty
+  // index is sampled again instead
+  inline void CountEntries(int64_t count) {
+    if (!has_stats_)
+      return;
+    if (stats_.entries == 0) {
+      has_stats_ = false;
+      return;
+    }
+    stats_.entries = std::max<int64_t>(stats_.entries + count, 0);
+    stats_.distinct_keys = std::llround(stats_.entries * distinct_ratio_);
+    IndexStats::Level &leaves = stats_.levels.back();
+    leaves.entries = stats_.entries;
+    leaves.pages =
+        std::max<int>(std::lround(stats_.entries / entries_per_leaf_), 1);
+  }
+
+  // indexed values of the tuple at rid, e.g. "1, abc"
+  inline std::string KeyString(const RID &rid, Transaction *txn) {
+    Tuple tuple(rid);
+    if (!table_heap_->GetTuple(rid, tuple, txn))
+      return "";
+    Tuple key = KeyOf(tuple);
+    std::string key_string;
+    for (int i = 0; i < index_->GetKeySchema()->GetColumnCount(); i++) {
+      if (i > 0)
+        key_string += ", ";
+      key_string += key.GetValue(index_->GetKeySchema(), i).ToString();
+    }
+    return key_string;
+  }
+
 private:
+  // take stats as the planner statistics
+  inline void SetIndexStats(const IndexStats &stats) {
+    stats_ = stats;
+    has_stats_ = true;
+    if (stats_.entries == 0)
+      return;
+    distinct_ratio_ =
+        static_cast<double>(stats_.distinct_keys) / stats_.entries;
+    entries_per_leaf_ = static_cast<double>(stats_.levels.back().entries) /
+                        stats_.levels.back().pages;
+  }
+
+  // construct indexed key tuple
+  inline Tuple KeyOf(const Tuple &tuple) {
+    std::vector<Value> key_values;
+    for (auto &i : index_->GetKeyAttrs())
+      key_values.push_back(tuple.GetValue(schema_, i));
+    return Tuple(key_values, index_->GetKeySchema());
+  }
+
+  // construct index entry tuple, the indexed key and the included columns
+  inline Tuple EntryOf(const Tuple &tuple) {
+    std::vector<Value> entry_values;
+    for (auto &i : index_->GetKeyAttrs())
+      entry_values.push_back(tuple.GetValue(schema_, i));
+    for (auto &i : index_->GetIncludeAttrs())
+      entry_values.push_back(tuple.GetValue(schema_, i));
+    return Tuple(entry_values, index_->GetEntrySchema());
+  }
+
   sqlite3_vtab base_;
+  // table name, key of its record in header page
+  std::string name_;
   // virtual table schema
   Schema *schema_;
   // to read/write actual data in table
   TableHeap *table_heap_;
   // to insert/delete index entry
   Index *index_ = nullptr;
+  IndexStats stats_;
+  bool has_stats_ = false;
+  // of stats_ when it was taken, CountEntries scales by them
+  double distinct_ratio_ = 1;
+  double entries_per_leaf_ = 1;
+  // rows inserted but not written yet, see BufferInsert
+  std::vector<Tuple> pending_;
 };
 
 class Cursor {
@@ -206,15 +469,26 @@ public:
 
   inline bool IsIndexScan() { return is_index_scan_; }
 
+  // answer indexed columns from the index key instead of the table heap
+  inline void SetCovering(bool is_covering) { is_covering_ = is_covering; }
+
   inline VirtualTable *GetVirtualTable() { return virtual_table_; }
 
+  // transaction the cursor began for a read, nullptr if it scans within a
+  // write transaction
+  inline void SetReadTransaction(Transaction *transaction) {
+    read_transaction_ = transaction;
+  }
+
+  inline Transaction *GetReadTransaction() { return read_transaction_; }
+
   inline Schema *GetKeySchema() {
     return virtual_table_->index_->GetKeySchema();
   }
   // return rid at which cursor is currently pointed
   inline int64_t GetCurrentRid() {
     if (is_index_scan_)
-      return results[offset_].Get();
+      return CurrentIndexRid().Get();
     else
       return (*table_iterator_).GetRid().Get();
   }
@@ -222,7 +496,14 @@ public:
   // return tuple at which cursor is currently pointed
   inline Value GetCurrentValue(Schema *schema, int column) {
     if (is_index_scan_) {
-      RID rid = results[offset_];
+      int key_column = KeyColumn(column);
+      if (is_covering_ && key_column >= 0) {
+        // every key of a point query equals the one looked up
+        if (range_scan_ != nullptr)
+          return range_scan_->GetKeyValue(key_column);
+        return scan_key_.GetValue(GetKeySchema(), key_column);
+      }
+      RID rid = CurrentIndexRid();
       Tuple tuple(rid);
       virtual_table_->table_heap_->GetTuple(rid, tuple, GetTransaction());
       return tuple.GetValue(schema, column);
@@ -233,7 +514,9 @@ public:
 
   // move cursor up to next
   Cursor &operator++() {
-    if (is_index_scan_)
+    if (range_scan_ != nullptr)
+      range_scan_->Next();
+    else if (is_index_scan_)
       ++offset_;
     else
       ++table_iterator_;
@@ -241,27 +524,105 @@ public:
   }
   // is end of cursor(no more tuple)
   inline bool isEof() {
+    if (range_scan_ != nullptr)
+      return range_scan_->IsEnd();
     if (is_index_scan_)
       return offset_ == static_cast<int>(results.size());
     else
       return table_iterator_ == virtual_table_->end();
   }
 
-  // wrapper around poit scan methods
+  // wrapper around poit scan methods, a filter may rewind the cursor
   inline void ScanKey(const Tuple &key) {
+    range_scan_.reset();
+    results.clear();
+    offset_ = 0;
+    scan_key_ = key;
     virtual_table_->index_->ScanKey(key, results);
   }
 
+  // wrapper around range scan, rids are copied out of the leaf pages a batch
+  // at a time
+  inline void ScanRange(const Tuple *low_key, bool low_inclusive,
+                        const Tuple *high_key, bool high_inclusive) {
+    range_scan_.reset();
+    range_scan_ = virtual_table_->index_->ScanRange(low_key, low_inclusive,
+                                                    high_key, high_inclusive);
+  }
+
 private:
+  inline RID CurrentIndexRid() {
+    if (range_scan_ != nullptr)
+      return range_scan_->GetRid();
+    return results[offset_];
+  }
+
+  // position of column in the index entry (key columns, then included
+  // columns), -1 if the index does not hold it
+  inline int KeyColumn(int column) {
+    const std::vector<int> &key_attrs = virtual_table_->index_->GetKeyAttrs();
+    auto it = std::find(key_attrs.begin(), key_attrs.end(), column);
+    if (it != key_attrs.end())
+      return it - key_attrs.begin();
+    const std::vector<int> &include_attrs =
+        virtual_table_->index_->GetIncludeAttrs();
+    it = std::find(include_attrs.begin(), include_attrs.end(), column);
+    if (it != include_attrs.end())
+      return key_attrs.size() + (it - include_attrs.begin());
+    return -1;
+  }
+
   sqlite3_vtab_cursor base_; /* Base class - must be first */
   // for index scan
   std::vector<RID> results;
   int offset_ = 0;
+  Tuple scan_key_;
+  // for index range scan
+  std::unique_ptr<IndexScanIterator> range_scan_;
   // for sequential scan
   TableIterator table_iterator_;
   // flag to indicate which scan method is currently used
   bool is_index_scan_ = false;
+  bool is_covering_ = false;
   VirtualTable *virtual_table_;
+  Transaction *read_transaction_ = nullptr;
 }; // namespace scudb
 
+// an index_stats, index_histogram or index_filter function
+class StatsTable {
+public:
+  StatsTable(sqlite3 *db, int kind) : db_(db), kind_(kind) {}
+
+  inline sqlite3 *GetDb() { return db_; }
+
+  inline int GetKind() { return kind_; }
+
+private:
+  sqlite3_vtab base_;
+  sqlite3 *db_;
+  int kind_;
+};
+
+// rows of a statistics function, all taken when it is called
+class StatsCursor {
+public:
+  inline void SetRows(std::vector<std::vector<Value>> &&rows) {
+    rows_ = std::move(rows);
+    offset_ = 0;
+  }
+
+  inline bool isEof() { return offset_ == rows_.size(); }
+
+  inline void Next() { ++offset_; }
+
+  inline const Value &GetValue(int column) { return rows_[offset_][column]; }
+
+  inline int64_t GetRowid() { return offset_; }
+
+private:
+  sqlite3_vtab_cursor base_; /* Base class - must be first */
+  std::vector<std::vector<Value>> rows_;
+  size_t offset_ = 0;
+};
+
 } // namespace scudb
\ No newline at end of file
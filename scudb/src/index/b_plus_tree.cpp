@@ -1,7 +1,11 @@
 /**
  * b_plus_tree.cpp
  */
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <random>
+#include <sstream>
 #include <string>
 
 #include "common/exception.h"
@@ -12,19 +16,84 @@
 
 namespace scudb {
 
+namespace {
+/*
+ * Split items of the given sizes into pages filled to capacity * fill_factor,
+ * at least half full, and return the number of items of every page. A short
+ * last page is folded into its predecessor or evened out with it so every
+ * page keeps the minimum occupancy
+ */
+std::vector<int> PageSizes(const std::vector<int> &item_sizes, int capacity,
+                           double fill_factor) {
+  int min_size = (capacity + 1) / 2;
+  int per_page = static_cast<int>(capacity * fill_factor);
+  per_page = std::min(std::max(per_page, min_size), capacity);
+  std::vector<int> counts, fills;
+  for (int item_size : item_sizes) {
+    if (counts.empty() || fills.back() + item_size > per_page) {
+      counts.push_back(0);
+      fills.push_back(0);
+    }
+    counts.back()++;
+    fills.back() += item_size;
+  }
+  if (counts.size() > 1 && fills.back() < min_size) {
+    int total = fills.back() + fills[fills.size() - 2];
+    int count = counts.back() + counts[counts.size() - 2];
+    counts.pop_back();
+    if (total <= capacity) {
+      counts.back() = count;
+    } else {
+      // the first page takes up to half of the total
+      int first = item_sizes.size() - count;
+      int half = 0, fill = 0;
+      while (fill + item_sizes[first + half] <= total / 2)
+        fill += item_sizes[first + half++];
+      counts.back() = half;
+      counts.push_back(count - half);
+    }
+  }
+  return counts;
+}
+
+/*
+ * Fixed size keys fill their slot whatever their bytes, so the first key of
+ * the right page stays the separator. Variable length keys are cut short,
+ * see index/varlen_key.h
+ */
+template <typename KeyType>
+KeyType ShortestSeparator(const KeyType &, const KeyType &right) {
+  return right;
+}
+} // namespace
+
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(const std::string &name,
                                 BufferPoolManager *buffer_pool_manager,
                                 const KeyComparator &comparator,
-                                page_id_t root_page_id)
-    : index_name_(name), root_page_id_(root_page_id),
-      buffer_pool_manager_(buffer_pool_manager), comparator_(comparator) {}
+                                page_id_t root_page_id, RootCatalog *catalog,
+                                bool own_file)
+    : index_name_(name),
+      root_page_id_(std::max(root_page_id, INVALID_PAGE_ID)),
+      file_id_(root_page_id < INVALID_PAGE_ID ? INVALID_PAGE_ID - root_page_id
+               : root_page_id != INVALID_PAGE_ID
+                   ? DiskManager::GetFileId(root_page_id)
+               : own_file ? -1
+                          : 0),
+      right_leaf_page_id_(INVALID_PAGE_ID), left_shifts_(0),
+      buffer_pool_manager_(buffer_pool_manager), catalog_(catalog),
+      comparator_(comparator) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_TYPE::~BPlusTree() { StopCompactionThread(); }
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const {
+  return root_page_id_ == INVALID_PAGE_ID;
+}
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -37,7 +106,103 @@ INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
                               std::vector<ValueType> &result,
                               Transaction *transaction) {
-  return false;
+  ValueType value;
+  uint64_t left_shifts = left_shifts_;
+  Page *page = FetchLeafPageBLink(key);
+  if (page != nullptr) {
+    auto *leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    bool found = leaf->Lookup(key, value, comparator_);
+    // a miss is only trusted if no key was shifted left meanwhile
+    bool valid = found || left_shifts == left_shifts_;
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (valid) {
+      if (found)
+        result.push_back(value);
+      return found;
+    }
+  }
+
+  page = FetchLeafPage(key, false, OpType::READ, transaction);
+  if (page == nullptr)
+    return false;
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  bool found = leaf->Lookup(key, value, comparator_);
+  if (found)
+    result.push_back(value);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  return found;
+}
+
+/*
+ * Batched point query: probe keys are sorted and the leaf that answered the
+ * previous key stays latched as long as it covers the next one. A key beyond
+ * the leaf's high key is first looked for on the right neighbour, and only
+ * if it lies further right the search starts over from the root. Misses
+ * follow the same rules as GetValue.
+ * @return : number of distinct keys found
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys,
+                              std::vector<ValueType> &result,
+                              Transaction *transaction) {
+  if (IsEmpty())
+    return 0;
+  std::vector<KeyType> sorted(keys);
+  std::sort(sorted.begin(), sorted.end(),
+            [this](const KeyType &a, const KeyType &b) {
+              return comparator_(a, b) < 0;
+            });
+  int num_found = 0;
+  Page *page = nullptr;
+  B_PLUS_TREE_LEAF_PAGE_TYPE *leaf = nullptr;
+  uint64_t left_shifts = left_shifts_;
+  for (size_t i = 0; i < sorted.size(); i++) {
+    const KeyType &key = sorted[i];
+    if (i > 0 && comparator_(key, sorted[i - 1]) == 0)
+      continue;
+    if (page != nullptr && leaf->IsBeyondHighKey(key, comparator_)) {
+      // step to the right neighbour, never holding two latches at once
+      page_id_t next_page_id = leaf->GetNextPageId();
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = FetchPage(next_page_id);
+      page->RLatch();
+      leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+      if (leaf->GetSize() == 0 || leaf->IsBeyondHighKey(key, comparator_)) {
+        page->RUnlatch();
+        buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+        page = nullptr;
+      }
+    }
+    if (page == nullptr) {
+      left_shifts = left_shifts_;
+      page = FetchLeafPageBLink(key);
+    }
+    if (page != nullptr) {
+      leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+      ValueType value;
+      if (leaf->Lookup(key, value, comparator_)) {
+        result.push_back(value);
+        num_found++;
+        continue;
+      }
+      if (left_shifts == left_shifts_)
+        continue;
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = nullptr;
+    }
+    if (GetValue(key, result, transaction))
+      num_found++;
+  }
+  if (page != nullptr) {
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+  return num_found;
 }
 
 /*****************************************************************************
@@ -53,7 +218,24 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
                             Transaction *transaction) {
-  return false;
+  // latch crabbing keeps its page set in a transaction
+  if (transaction == nullptr) {
+    Transaction local_transaction(0);
+    return Insert(key, value, &local_transaction);
+  }
+  // the root id is atomic, the root latch is only needed to start a tree.
+  // InsertIntoLeaf copes with a tree emptied in the meantime
+  if (IsEmpty()) {
+    std::lock_guard<std::mutex> guard(root_latch_);
+    if (IsEmpty()) {
+      StartNewTree(key, value);
+      return true;
+    }
+  }
+  bool inserted;
+  if (InsertIntoRightLeaf(key, value, inserted))
+    return inserted;
+  return InsertIntoLeaf(key, value, transaction);
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -62,7 +244,20 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value,
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  OpenFile();
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(page_id, file_id_);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *root = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  root->Init(page_id);
+  root->Insert(key, value, comparator_);
+  RememberRightLeaf(root);
+  root_page_id_ = page_id;
+  UpdateRootPageId(true);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
@@ -75,7 +270,104 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
                                     Transaction *transaction) {
-  return false;
+  // optimistic pass: read latches down to the leaf, write latch on the leaf
+  Page *page = FetchLeafPage(key, false, OpType::INSERT, transaction, true);
+  if (page != nullptr) {
+    auto *leaf =
+        reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+    ValueType existing;
+    bool duplicate = leaf->Lookup(key, existing, comparator_);
+    bool done = duplicate || IsSafe(leaf, OpType::INSERT);
+    if (done && !duplicate) {
+      leaf->Insert(key, value, comparator_);
+      RememberRightLeaf(leaf);
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), done && !duplicate);
+    if (done)
+      return !duplicate;
+  }
+
+  // the leaf is full, start over holding write latches from the root down
+  page = FetchLeafPage(key, false, OpType::INSERT, transaction);
+  if (page == nullptr) {
+    // the tree was emptied after Insert looked at it
+    ReleasePageSet(transaction, false);
+    return Insert(key, value, transaction);
+  }
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  ValueType existing;
+  if (leaf->Lookup(key, existing, comparator_)) {
+    ReleasePageSet(transaction, false);
+    return false;
+  }
+  bool append = leaf->GetNextPageId() == INVALID_PAGE_ID &&
+                comparator_(key, leaf->KeyAt(leaf->GetSize() - 1)) > 0;
+  leaf->Insert(key, value, comparator_);
+  RememberRightLeaf(leaf);
+  if (leaf->IsOverflow()) {
+    B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf =
+        append ? SplitAppend(leaf) : Split(leaf);
+    KeyType separator = ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1),
+                                          new_leaf->KeyAt(0));
+    leaf->SetHighKey(separator);
+    InsertIntoParent(leaf, separator, new_leaf, transaction);
+    RememberRightLeaf(new_leaf);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+  }
+  ReleasePageSet(transaction, true);
+  return true;
+}
+
+/*
+ * Append fast path: write latch the remembered right-most leaf, nothing else.
+ * It is used only while it is still the right-most leaf (no right link, not
+ * emptied by a merge), key is not below its first key, so it lies in the
+ * leaf's range, and the insert does not split it.
+ * @return: false if the fast path does not apply, inserted tells otherwise
+ * whether key was new
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::InsertIntoRightLeaf(const KeyType &key,
+                                         const ValueType &value,
+                                         bool &inserted) {
+  page_id_t page_id = right_leaf_page_id_;
+  if (page_id == INVALID_PAGE_ID)
+    return false;
+  // page ids are not recycled, a leaf deleted since is read back empty
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    return false;
+  page->WLatch();
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  bool usable = leaf->IsLeafPage() && leaf->GetSize() > 0 &&
+                leaf->GetNextPageId() == INVALID_PAGE_ID &&
+                comparator_(key, leaf->KeyAt(0)) >= 0;
+  if (usable &&
+      comparator_(key, leaf->KeyAt(leaf->GetSize() - 1)) > 0) {
+    // past the last key: nothing to search for and nothing to shift
+    inserted = true;
+    usable = IsSafe(leaf, OpType::INSERT);
+    if (usable) {
+      MappingType item(key, value);
+      leaf->CopyNFrom(&item, 1, buffer_pool_manager_);
+    }
+  } else if (usable) {
+    ValueType existing;
+    inserted = !leaf->Lookup(key, existing, comparator_);
+    usable = !inserted || IsSafe(leaf, OpType::INSERT);
+    if (usable && inserted)
+      leaf->Insert(key, value, comparator_);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, usable && inserted);
+  return usable;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RememberRightLeaf(const B_PLUS_TREE_LEAF_PAGE_TYPE *leaf) {
+  if (leaf->GetNextPageId() == INVALID_PAGE_ID)
+    right_leaf_page_id_ = leaf->GetPageId();
 }
 
 /*
@@ -86,7 +378,35 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
  * of key & value pairs from input page to newly created page
  */
 INDEX_TEMPLATE_ARGUMENTS
-template <typename N> N *BPLUSTREE_TYPE::Split(N *node) { return nullptr; }
+template <typename N> N *BPLUSTREE_TYPE::Split(N *node) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(page_id, file_id_);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  N *new_node = reinterpret_cast<N *>(page->GetData());
+  new_node->Init(page_id, node->GetParentPageId());
+  node->MoveHalfTo(new_node, buffer_pool_manager_);
+  return new_node;
+}
+
+/*
+ * Split the right-most leaf after an append past its last key: the new leaf
+ * starts with just the appended pair, so the split copies nothing else and
+ * ascending inserts leave full leaves behind instead of half empty ones.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+B_PLUS_TREE_LEAF_PAGE_TYPE *
+BPLUSTREE_TYPE::SplitAppend(B_PLUS_TREE_LEAF_PAGE_TYPE *leaf) {
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(page_id, file_id_);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *new_leaf =
+      reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  new_leaf->Init(page_id, leaf->GetParentPageId());
+  leaf->MoveLastTo(new_leaf, buffer_pool_manager_);
+  return new_leaf;
+}
 
 /*
  * Insert key & value pair into internal page after split
@@ -101,7 +421,113 @@ INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
                                       const KeyType &key,
                                       BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+                                      Transaction *transaction) {
+  if (old_node->IsRootPage()) {
+    // the root latch is still held, nobody else can see the root change
+    page_id_t root_id;
+    Page *page = buffer_pool_manager_->NewPage(root_id, file_id_);
+    if (page == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    auto *root = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
+    root->Init(root_id);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_id);
+    new_node->SetParentPageId(root_id);
+    root_page_id_ = root_id;
+    UpdateRootPageId();
+    buffer_pool_manager_->UnpinPage(root_id, true);
+    return;
+  }
+
+  // the parent is write latched by this thread since old_node was not safe
+  Page *page = FetchPage(old_node->GetParentPageId());
+  auto *parent = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(page->GetData());
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  if (parent->IsOverflow()) {
+    B_PLUS_TREE_INTERNAL_PAGE *new_parent = Split(parent);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent, transaction);
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
+}
+
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+/*
+ * Build the tree bottom-up from items sorted by key without duplicates: pack
+ * the leaves left to right, then build each internal level from the first key
+ * and page id of the level below until a single root remains. Much cheaper
+ * than inserting one by one since every page is written exactly once.
+ * @return: false if the tree is not empty
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(const std::vector<MappingType> &items,
+                              double fill_factor) {
+  std::lock_guard<std::mutex> guard(root_latch_);
+  if (!IsEmpty())
+    return false;
+  if (items.empty())
+    return true;
+  OpenFile();
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  BuildLevel<B_PLUS_TREE_LEAF_PAGE_TYPE>(items.data(), items.size(),
+                                         fill_factor, &level);
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> parent_level;
+    BuildLevel<B_PLUS_TREE_INTERNAL_PAGE>(level.data(), level.size(),
+                                          fill_factor, &parent_level);
+    level.swap(parent_level);
+  }
+  root_page_id_ = level[0].second;
+  UpdateRootPageId(true);
+  return true;
+}
+
+/*
+ * Fill one level of pages from sorted items, chaining them with right links
+ * and high keys, and append (first key, page id) of every page to
+ * parent_items for the level above
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N, typename ItemType>
+void BPLUSTREE_TYPE::BuildLevel(
+    const ItemType *items, int count, double fill_factor,
+    std::vector<std::pair<KeyType, page_id_t>> *parent_items) {
+  N *prev = nullptr;
+  int offset = 0;
+  std::vector<int> sizes;
+  for (size_t i = 0; offset < count; i++) {
+    page_id_t page_id;
+    Page *page = buffer_pool_manager_->NewPage(page_id, file_id_);
+    if (page == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    N *node = reinterpret_cast<N *>(page->GetData());
+    node->Init(page_id);
+    if (sizes.empty()) {
+      std::vector<int> item_sizes;
+      for (int j = 0; j < count; j++)
+        item_sizes.push_back(N::ItemSize(items[j]));
+      sizes = PageSizes(item_sizes, node->GetCapacity(), fill_factor);
+    }
+    node->CopyNFrom(items + offset, sizes[i], buffer_pool_manager_);
+    offset += sizes[i];
+    KeyType separator = node->KeyAt(0);
+    if (prev != nullptr) {
+      // internal pages do not know the largest key below their last child
+      if (node->IsLeafPage())
+        separator =
+            ShortestSeparator(prev->KeyAt(prev->GetSize() - 1), separator);
+      prev->SetNextPageId(page_id);
+      prev->SetHighKey(separator);
+      buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+    }
+    parent_items->emplace_back(separator, page_id);
+    prev = node;
+  }
+  if (prev != nullptr)
+    buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -112,21 +538,113 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node,
  * If not, User needs to first find the right leaf page as deletion target, then
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
+ * Deletes are lazy: only a leaf the delete empties is merged right away, one
+ * left underfull is handed to Compact.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  if (transaction == nullptr) {
+    Transaction local_transaction(0);
+    Remove(key, &local_transaction);
+    return;
+  }
+  // optimistic pass: read latches down to the leaf, write latch on the leaf
+  Page *page = FetchLeafPage(key, false, OpType::DELETE, transaction, true);
+  if (page == nullptr)
+    return;
+  auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  ValueType existing;
+  bool found = leaf->Lookup(key, existing, comparator_);
+  bool done = !found || IsSafe(leaf, OpType::DELETE);
+  if (found && done) {
+    leaf->RemoveAndDeleteRecord(key, comparator_);
+    // may be the root, Compact checks that
+    if (leaf->IsBelowMinSize())
+      AddCompactionCandidate(page->GetPageId());
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetPageId(), found && done);
+  if (done)
+    return;
+
+  // the leaf would be emptied, start over holding write latches from the root
+  page = FetchLeafPage(key, false, OpType::DELETE, transaction);
+  if (page == nullptr) {
+    ReleasePageSet(transaction, false);
+    return;
+  }
+  leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+  int size = leaf->GetSize();
+  if (leaf->RemoveAndDeleteRecord(key, comparator_) == size) {
+    ReleasePageSet(transaction, false);
+    return;
+  }
+  if (IsUnderflow(leaf, OpType::DELETE))
+    CoalesceOrRedistribute(leaf, transaction);
+  else if (leaf->IsUnderflow())
+    AddCompactionCandidate(page->GetPageId());
+  ReleasePageSet(transaction, true);
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
  * page's size > page's max size, then redistribute. Otherwise, merge.
+ * With variable length keys the key moving up to the parent may not fit, the
+ * node is then left as it is: underfull but still correct.
+ * op: DELETE restructures emptied nodes only and moves a single entry when
+ * redistributing, COMPACT restores the minimum occupancy of both nodes.
  * Using template N to represent either internal page or leaf page.
  * @return: true means target leaf page should be deleted, false means no
  * deletion happens
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction,
+                                            OpType op) {
+  if (node->IsRootPage()) {
+    if (!AdjustRoot(node))
+      return false;
+    transaction->AddIntoDeletedPageSet(node->GetPageId());
+    return true;
+  }
+
+  // parent is write latched by this thread, the sibling is latched under it
+  Page *parent_page = FetchPage(node->GetParentPageId());
+  auto *parent =
+      reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(parent_page->GetData());
+  int index = parent->ValueIndex(node->GetPageId());
+  // only a parent left underfull (see above) can be without a sibling
+  if (parent->GetSize() == 1) {
+    buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+    return false;
+  }
+  Page *neighbor_page = FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+  neighbor_page->WLatch();
+  transaction->AddIntoPageSet(neighbor_page);
+  N *neighbor_node = reinterpret_cast<N *>(neighbor_page->GetData());
+
+  bool node_deleted = false;
+  if (node->CanMergeWith(neighbor_node)) {
+    // always fold the right page into the left one
+    node_deleted = index != 0;
+    if (index == 0) {
+      std::swap(neighbor_node, node);
+      index = 1;
+    }
+    Coalesce(neighbor_node, node, parent, index, transaction, op);
+  } else {
+    do {
+      if (!parent->CanSetKeyAt(
+              index == 0 ? 1 : index,
+              neighbor_node->KeyAt(
+                  index == 0 ? 1 : neighbor_node->GetSize() - 1)))
+        break;
+      Redistribute(neighbor_node, node, index);
+    } while (op == OpType::COMPACT && node->IsUnderflow() &&
+             neighbor_node->IsSafeToRemove());
+  }
+  buffer_pool_manager_->UnpinPage(parent->GetPageId(), true);
+  return node_deleted;
 }
 
 /*
@@ -146,7 +664,12 @@ template <typename N>
 bool BPLUSTREE_TYPE::Coalesce(
     N *&neighbor_node, N *&node,
     BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> *&parent,
-    int index, Transaction *transaction) {
+    int index, Transaction *transaction, OpType op) {
+  node->MoveAllTo(neighbor_node, index, buffer_pool_manager_);
+  transaction->AddIntoDeletedPageSet(node->GetPageId());
+  parent->Remove(index);
+  if (IsUnderflow(parent, op))
+    return CoalesceOrRedistribute(parent, transaction, op);
   return false;
 }
 
@@ -161,7 +684,15 @@ bool BPLUSTREE_TYPE::Coalesce(
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  if (index == 0) {
+    // B-link readers only recover from keys moving right, see GetValue
+    left_shifts_++;
+    neighbor_node->MoveFirstToEndOf(node, buffer_pool_manager_);
+  } else {
+    neighbor_node->MoveLastToFrontOf(node, index, buffer_pool_manager_);
+  }
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -174,6 +705,23 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+  // case 1: promote the only child
+  if (!old_root_node->IsLeafPage() && old_root_node->GetSize() == 1) {
+    auto *root = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(old_root_node);
+    root_page_id_ = root->RemoveAndReturnOnlyChild();
+    UpdateRootPageId();
+    Page *page = FetchPage(root_page_id_);
+    reinterpret_cast<BPlusTreePage *>(page->GetData())
+        ->SetParentPageId(INVALID_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    return true;
+  }
+  // case 2: the tree is empty now
+  if (old_root_node->IsLeafPage() && old_root_node->GetSize() == 0) {
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId();
+    return true;
+  }
   return false;
 }
 
@@ -186,7 +734,11 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  KeyType key;
+  Page *page = FetchLeafPage(key, true, OpType::READ, nullptr);
+  return INDEXITERATOR_TYPE(page, 0, buffer_pool_manager_);
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -195,7 +747,12 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  */
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
-  return INDEXITERATOR_TYPE();
+  Page *page = FetchLeafPage(key, false, OpType::READ, nullptr);
+  int index = 0;
+  if (page != nullptr)
+    index = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData())
+                ->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(page, index, buffer_pool_manager_);
 }
 
 /*****************************************************************************
@@ -208,9 +765,190 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
 INDEX_TEMPLATE_ARGUMENTS
 B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
                                                          bool leftMost) {
+  Page *page = FetchLeafPage(key, leftMost, OpType::READ, nullptr);
+  if (page == nullptr)
+    return nullptr;
+  return reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+}
+
+/*
+ * Descend from the root to the leaf for key, crabbing latches on the way.
+ * READ: read latch the child, then release the parent. The leaf is returned
+ * read latched and the transaction is not used.
+ * INSERT/DELETE: write latch the child and, if it is safe for the operation,
+ * release everything held above it. All held pages (and the root latch, as a
+ * nullptr entry) stay in the transaction's page set for ReleasePageSet.
+ * Return nullptr if the tree is empty, a writer then still holds the root
+ * latch.
+ * optimistic INSERT/DELETE: crab read latches like READ and write latch only
+ * the leaf, which is returned pinned and outside of the page set. The caller
+ * retries pessimistically if the leaf turns out not to be safe.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchLeafPage(const KeyType &key, bool leftMost,
+                                    OpType op, Transaction *transaction,
+                                    bool optimistic) {
+  bool crab_read = op == OpType::READ || optimistic;
+  root_latch_.lock();
+  if (!crab_read)
+    transaction->AddIntoPageSet(nullptr);
+  if (IsEmpty()) {
+    if (crab_read)
+      root_latch_.unlock();
+    return nullptr;
+  }
+
+  Page *parent = nullptr; // read crabbing only
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      if (!crab_read) {
+        ReleasePageSet(transaction, false);
+      } else if (parent == nullptr) {
+        root_latch_.unlock();
+      } else {
+        parent->RUnlatch();
+        buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+      }
+      throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    }
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+
+    if (crab_read) {
+      // the latched parent (or root latch) keeps the child from being merged
+      // away, so its page type can be read before picking the latch mode
+      if (op != OpType::READ && node->IsLeafPage())
+        page->WLatch();
+      else
+        page->RLatch();
+      if (parent == nullptr) {
+        root_latch_.unlock();
+      } else {
+        parent->RUnlatch();
+        buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+      }
+      parent = page;
+    } else {
+      page->WLatch();
+      bool safe =
+          node->IsLeafPage()
+              ? IsSafe(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node), op)
+              : IsSafe(reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node), op);
+      if (safe)
+        ReleasePageSet(transaction, false);
+      transaction->AddIntoPageSet(page);
+    }
+
+    if (node->IsLeafPage())
+      return page;
+    auto *internal = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+    page_id =
+        leftMost ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+  }
+}
+
+/*
+ * B-link descent for point lookups: hold one read latch at a time and follow
+ * the right link whenever key is at or beyond the high key of a page. The
+ * leaf is returned pinned and read latched. Return nullptr if the tree is
+ * empty or the descent ran into a page emptied by a merge
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchLeafPageBLink(const KeyType &key) {
+  page_id_t page_id = root_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = FetchPage(page_id);
+    page->RLatch();
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (node->GetSize() == 0) {
+      page_id = INVALID_PAGE_ID;
+    } else if (node->IsLeafPage()) {
+      auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+      if (!leaf->IsBeyondHighKey(key, comparator_))
+        return page;
+      page_id = leaf->GetNextPageId();
+    } else {
+      auto *internal = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+      page_id = internal->IsBeyondHighKey(key, comparator_)
+                    ? internal->GetNextPageId()
+                    : internal->Lookup(key, comparator_);
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
   return nullptr;
 }
 
+/*
+ * A node is safe when the operation can not propagate above it: an insert
+ * does not split it, a delete does not empty it, a compaction does not make it
+ * underflow
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N> bool BPLUSTREE_TYPE::IsSafe(N *node, OpType op) {
+  if (op == OpType::INSERT)
+    return node->IsSafeToInsert();
+  if (op == OpType::DELETE)
+    return node->IsSafeToRemoveLazily();
+  if (op == OpType::COMPACT)
+    return node->IsSafeToRemove();
+  return true;
+}
+
+/*
+ * A node underflows when the operation has to merge or redistribute it
+ */
+INDEX_TEMPLATE_ARGUMENTS
+template <typename N> bool BPLUSTREE_TYPE::IsUnderflow(N *node, OpType op) {
+  return op == OpType::COMPACT ? node->IsUnderflow() : node->IsEmpty();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::AddCompactionCandidate(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(compaction_latch_);
+  underfull_pages_.insert(page_id);
+}
+
+/*
+ * Unlatch and unpin every page held in the transaction's page set (a nullptr
+ * entry stands for the root latch), then delete the pages emptied by merges.
+ * Deleting only after unpinning lets the buffer pool reclaim the frames. The
+ * empty page is flushed first: page ids are not recycled, so a B-link reader
+ * still heading for it reads it back from disk and sees that it is gone
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleasePageSet(Transaction *transaction, bool is_dirty) {
+  auto page_set = transaction->GetPageSet();
+  for (Page *page : *page_set) {
+    if (page == nullptr) {
+      root_latch_.unlock();
+      continue;
+    }
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  page_set->clear();
+
+  auto deleted_page_set = transaction->GetDeletedPageSet();
+  for (page_id_t page_id : *deleted_page_set) {
+    buffer_pool_manager_->FlushPage(page_id);
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  deleted_page_set->clear();
+}
+
+/*
+ * Fetch (pin) a page, throw if every frame of the buffer pool is pinned
+ */
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return page;
+}
+
 /*
  * Update/Insert root page id in header page(where page_id = 0, header_page is
  * defined under include/page/header_page.h)
@@ -218,26 +956,313 @@ B_PLUS_TREE_LEAF_PAGE_TYPE *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key,
  * @parameter: insert_record      defualt value is false. When set to true,
  * insert a record <index_name, root_page_id> into header page instead of
  * updating it.
+ * With a catalog the header page is only written if the catalog does not
+ * hold the same root already. An empty tree records INVALID_PAGE_ID - file id
+ * so that a tree owning its data file finds it again.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
+  page_id_t root_page_id =
+      IsEmpty() ? INVALID_PAGE_ID - file_id_ : root_page_id_.load();
+  if (catalog_ != nullptr) {
+    if (!catalog_->SetRootId(index_name_, root_page_id))
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "can't record the root page of " + index_name_);
+    return;
+  }
   HeaderPage *header_page = static_cast<HeaderPage *>(
       buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
   if (insert_record)
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  else
+    // create a new record<index_name + root_page_id> in header_page, a tree
+    // that was emptied before already has one
+    insert_record = header_page->InsertRecord(index_name_, root_page_id);
+  if (!insert_record)
     // update root_page_id in header_page
-    header_page->UpdateRecord(index_name_, root_page_id_);
+    header_page->UpdateRecord(index_name_, root_page_id);
   buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
+/*
+ * A tree owning its data file creates it along with its first page, the
+ * shared file 0 takes its pages if no file can be added. The file stays
+ * when the tree is emptied
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::OpenFile() {
+  if (file_id_ < 0)
+    file_id_ = std::max(buffer_pool_manager_->CreateFile(), 0);
+}
+
 /*
  * This method is used for debug only
  * print out whole b+tree sturcture, rank by rank
  */
 INDEX_TEMPLATE_ARGUMENTS
-std::string BPLUSTREE_TYPE::ToString(bool verbose) { return "Empty tree"; }
+std::string BPLUSTREE_TYPE::ToString(bool verbose) {
+  if (IsEmpty())
+    return "Empty tree";
+  std::ostringstream os;
+  std::queue<BPlusTreePage *> level, next_level;
+  level.push(
+      reinterpret_cast<BPlusTreePage *>(FetchPage(root_page_id_)->GetData()));
+  while (!level.empty()) {
+    bool first = true;
+    while (!level.empty()) {
+      BPlusTreePage *node = level.front();
+      level.pop();
+      if (!first)
+        os << " | ";
+      first = false;
+      if (node->IsLeafPage()) {
+        os << reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->ToString(
+            verbose);
+      } else {
+        auto *internal = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+        os << internal->ToString(verbose);
+        internal->QueueUpChildren(&next_level, buffer_pool_manager_);
+      }
+      buffer_pool_manager_->UnpinPage(node->GetPageId(), false);
+    }
+    os << "\n";
+    std::swap(level, next_level);
+  }
+  return os.str();
+}
+
+/*
+ * Walk every level along the right links, starting from the first child of
+ * the level above. Pages are read latched one at a time, a concurrent writer
+ * may skew the numbers but is never held up for long
+ */
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<IndexStats::Level> BPLUSTREE_TYPE::GetLevelStats() {
+  std::vector<IndexStats::Level> levels;
+  page_id_t first_page_id = root_page_id_;
+  while (first_page_id != INVALID_PAGE_ID) {
+    IndexStats::Level level = {0, 0, 0};
+    page_id_t child_page_id = INVALID_PAGE_ID;
+    page_id_t page_id = first_page_id;
+    while (page_id != INVALID_PAGE_ID) {
+      Page *page = FetchPage(page_id);
+      page->RLatch();
+      auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+      level.pages++;
+      level.entries += node->GetSize();
+      if (node->IsLeafPage()) {
+        auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+        level.fill_factor += leaf->GetFillFactor();
+        page_id = leaf->GetNextPageId();
+      } else {
+        auto *internal = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+        level.fill_factor += internal->GetFillFactor();
+        if (child_page_id == INVALID_PAGE_ID && internal->GetSize() > 0)
+          child_page_id = internal->ValueAt(0);
+        page_id = internal->GetNextPageId();
+      }
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    level.fill_factor /= level.pages;
+    levels.push_back(level);
+    first_page_id = child_page_id;
+  }
+  return levels;
+}
+
+/*
+ * Descend from the root to a random child, paths times, latch coupling on the
+ * way down. A level is estimated to have as many pages as the level above has
+ * entries, each holding the average number of entries seen on that level
+ */
+INDEX_TEMPLATE_ARGUMENTS
+std::vector<IndexStats::Level>
+BPLUSTREE_TYPE::SampleLevelStats(int paths, std::vector<KeyType> &leaf_keys) {
+  std::vector<IndexStats::Level> levels;
+  // the same plan for the same tree
+  std::minstd_rand random(static_cast<unsigned>(root_page_id_));
+  for (int path = 0; path < paths; path++) {
+    page_id_t page_id = root_page_id_;
+    Page *parent = nullptr;
+    for (size_t depth = 0; page_id != INVALID_PAGE_ID; depth++) {
+      Page *page = FetchPage(page_id);
+      page->RLatch();
+      if (parent != nullptr) {
+        parent->RUnlatch();
+        buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+      }
+      parent = page;
+      if (levels.size() <= depth)
+        levels.push_back({0, 0, 0});
+      auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+      levels[depth].pages++;
+      levels[depth].entries += node->GetSize();
+      page_id = INVALID_PAGE_ID;
+      if (node->IsLeafPage()) {
+        auto *leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node);
+        levels[depth].fill_factor += leaf->GetFillFactor();
+        if (leaf->GetSize() > 0)
+          leaf_keys.push_back(leaf->KeyAt(0));
+      } else {
+        auto *internal = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+        levels[depth].fill_factor += internal->GetFillFactor();
+        if (internal->GetSize() > 0)
+          page_id = internal->ValueAt(random() % internal->GetSize());
+      }
+    }
+    if (parent != nullptr) {
+      parent->RUnlatch();
+      buffer_pool_manager_->UnpinPage(parent->GetPageId(), false);
+    }
+  }
+  // levels now hold the visits, turn averages per page into level totals
+  double pages = 1;
+  for (auto &level : levels) {
+    double entries_per_page = static_cast<double>(level.entries) / level.pages;
+    level.fill_factor /= level.pages;
+    level.pages = std::max(static_cast<int>(std::round(pages)), 1);
+    level.entries = static_cast<int64_t>(std::round(pages * entries_per_page));
+    pages = pages * entries_per_page;
+  }
+  return levels;
+}
+
+/*****************************************************************************
+ * COMPACTION
+ *****************************************************************************/
+/*
+ * Descend to every leaf a delete left underfull, holding write latches like a
+ * delete that can not leave a page underflowing, and merge it into or even it
+ * out with a sibling, up the tree as far as parents underflow. A leaf that was
+ * merged away, refilled or emptied in the meantime is skipped. The emptied
+ * pages go back to the buffer pool via ReleasePageSet.
+ * If the buffer pool runs out of frames the pass stops, the leaves not done
+ * yet are tried again by the next one
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_TYPE::Compact(Transaction *transaction) {
+  if (transaction == nullptr) {
+    Transaction local_transaction(0);
+    return Compact(&local_transaction);
+  }
+  std::set<page_id_t> page_ids;
+  {
+    std::lock_guard<std::mutex> lock(compaction_latch_);
+    page_ids.swap(underfull_pages_);
+  }
+
+  int freed = 0;
+  for (auto it = page_ids.begin(); it != page_ids.end(); ++it) {
+    try {
+      // a leaf keeps its first key, which leads the descent back to it
+      Page *page = FetchPage(*it);
+      page->RLatch();
+      auto *leaf =
+          reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+      bool underflow =
+          leaf->IsLeafPage() && leaf->GetSize() > 0 && leaf->IsBelowMinSize();
+      KeyType key;
+      if (underflow)
+        key = leaf->KeyAt(0);
+      page->RUnlatch();
+      buffer_pool_manager_->UnpinPage(*it, false);
+      if (!underflow)
+        continue;
+
+      page = FetchLeafPage(key, false, OpType::COMPACT, transaction);
+      if (page == nullptr) {
+        ReleasePageSet(transaction, false);
+        continue;
+      }
+      leaf = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page->GetData());
+      bool is_dirty = IsUnderflow(leaf, OpType::COMPACT);
+      if (is_dirty)
+        CoalesceOrRedistribute(leaf, transaction, OpType::COMPACT);
+      freed += transaction->GetDeletedPageSet()->size();
+      ReleasePageSet(transaction, is_dirty);
+    } catch (Exception &) {
+      ReleasePageSet(transaction, true);
+      std::lock_guard<std::mutex> lock(compaction_latch_);
+      underfull_pages_.insert(it, page_ids.end());
+      break;
+    }
+  }
+  return freed;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::RunCompactionThread() {
+  if (compaction_thread_ != nullptr)
+    return;
+  stop_compaction_ = false;
+  compaction_thread_ = new std::thread([this] {
+    std::unique_lock<std::mutex> lock(compaction_latch_);
+    while (!stop_compaction_) {
+      compaction_cv_.wait_for(lock, COMPACTION_TIMEOUT);
+      if (stop_compaction_ || underfull_pages_.empty())
+        continue;
+      lock.unlock();
+      Compact();
+      lock.lock();
+    }
+  });
+}
+
+/*
+ * Stop and join the compaction thread, a pass under way is finished first
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::StopCompactionThread() {
+  if (compaction_thread_ == nullptr)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(compaction_latch_);
+    stop_compaction_ = true;
+  }
+  compaction_cv_.notify_one();
+  compaction_thread_->join();
+  delete compaction_thread_;
+  compaction_thread_ = nullptr;
+}
+
+/*
+ * Drop the index: a tree in a data file of its own drops the file, one in
+ * the shared file deletes its pages level by level from the root. Return
+ * false if a page is still pinned or the file can not be dropped
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::DeleteTree() {
+  StopCompactionThread();
+  std::lock_guard<std::mutex> guard(root_latch_);
+  if (file_id_ > 0) {
+    if (!buffer_pool_manager_->DropFile(file_id_))
+      return false;
+    root_page_id_ = INVALID_PAGE_ID;
+    return true;
+  }
+  std::vector<page_id_t> level;
+  if (!IsEmpty())
+    level.push_back(root_page_id_);
+  while (!level.empty()) {
+    std::vector<page_id_t> child_level;
+    for (page_id_t page_id : level) {
+      Page *page = buffer_pool_manager_->FetchPage(page_id);
+      if (page == nullptr)
+        return false;
+      auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+      if (!node->IsLeafPage()) {
+        auto *internal = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE *>(node);
+        for (int i = 0; i < internal->GetSize(); i++)
+          child_level.push_back(internal->ValueAt(i));
+      }
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      if (!buffer_pool_manager_->DeletePage(page_id))
+        return false;
+    }
+    level.swap(child_level);
+  }
+  root_page_id_ = INVALID_PAGE_ID;
+  return true;
+}
 
 /*
  * This method is used for test only
@@ -276,8 +1301,16 @@ void BPLUSTREE_TYPE::RemoveFromFile(const std::string &file_name,
 
 template class BPlusTree<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+template class BPlusTree<GenericKey<12>, RID, GenericComparator<12>>;
 template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
+template class BPlusTree<GenericKey<24>, RID, GenericComparator<24>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
+template class BPlusTree<GenericKey<48>, RID, GenericComparator<48>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTree<VarlenKey, RID, VarlenComparator>;
+template class BPlusTree<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class BPlusTree<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class BPlusTree<IntegerKey<12>, RID, IntegerComparator<12>>;
+template class BPlusTree<IntegerKey<16>, RID, IntegerComparator<16>>;
 
 } // namespace scudb
@@ -2,53 +2,605 @@
  * b_plus_tree_index.cpp
  */
 
+#include <algorithm>
+#include <cstring>
+
 #include "index/b_plus_tree_index.h"
+#include "type/limits.h"
 
 namespace scudb {
+
+namespace {
+// rid column values bracketing every rid of a key
+const int64_t MIN_RID = 0;
+const int64_t MAX_RID = PELOTON_INT64_MAX;
+// keys a new filter is sized for
+const int64_t FILTER_INITIAL_KEYS = 1024;
+// entries a range scan copies out of the tree at a time
+const size_t SCAN_BATCH_SIZE = 64;
+
+// key schema of a non-unique index: the indexed columns followed by the rid,
+// then by the included columns
+Schema *AppendRidColumn(const Schema *schema, int key_columns) {
+  std::vector<Column> columns;
+  for (int i = 0; i < key_columns; i++)
+    columns.push_back(schema->GetColumn(i));
+  columns.push_back(Column(TypeId::BIGINT, sizeof(int64_t), "__rid"));
+  for (int i = key_columns; i < schema->GetColumnCount(); i++)
+    columns.push_back(schema->GetColumn(i));
+  return new Schema(columns);
+}
+
+// bytes of a non-unique tree key in front of its rid
+template <size_t KeySize>
+int KeyPrefixSize(const GenericKey<KeySize> &, Schema *key_schema) {
+  return KeyEncoder::MaxLength(key_schema);
+}
+
+int KeyPrefixSize(const VarlenKey &key, Schema *key_schema) {
+  return KeyEncoder::Length(key.data, key_schema);
+}
+
+template <size_t KeySize>
+int KeyPrefixSize(const IntegerKey<KeySize> &, Schema *) {
+  return sizeof(typename IntegerKey<KeySize>::IntType);
+}
+} // namespace
+
+/*
+ * Range scan
+ */
+INDEX_TEMPLATE_ARGUMENTS
+BPlusTreeIndexScan<KeyType, ValueType, KeyComparator>::BPlusTreeIndexScan(
+    BPlusTree<KeyType, ValueType, KeyComparator> *tree,
+    const std::atomic<int64_t> *deletes, INDEXITERATOR_TYPE &&iterator,
+    const KeyComparator &comparator, Schema *key_schema, int rid_column,
+    const KeyType *low_key, bool low_inclusive, const KeyType *high_key,
+    bool high_inclusive)
+    : tree_(tree), deletes_(deletes), offset_(0), done_(false), comparator_(comparator),
+      key_schema_(key_schema), rid_column_(rid_column),
+      has_high_key_(high_key != nullptr), high_inclusive_(high_inclusive) {
+  if (has_high_key_)
+    high_key_ = *high_key;
+  // an open lower bound skips the entries equal to it
+  if (low_key != nullptr && !low_inclusive)
+    while (!iterator.isEnd() && comparator_((*iterator).first, *low_key) == 0)
+      ++iterator;
+  Fill(iterator);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPlusTreeIndexScan<KeyType, ValueType, KeyComparator>::Next() {
+  KeyType last_key = entries_[offset_++].first;
+  bool stale = *deletes_ != batch_deletes_;
+  if (offset_ < entries_.size() ? !stale : done_)
+    return;
+  // resume after the last key handed out, wherever it lives by now
+  auto iterator = tree_->Begin(last_key);
+  if (!iterator.isEnd() && comparator_((*iterator).first, last_key) == 0)
+    ++iterator;
+  Fill(iterator);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPlusTreeIndexScan<KeyType, ValueType, KeyComparator>::Fill(
+    INDEXITERATOR_TYPE &iterator) {
+  batch_deletes_ = *deletes_;
+  entries_.clear();
+  offset_ = 0;
+  done_ = false;
+  for (; !iterator.isEnd(); ++iterator) {
+    if (entries_.size() == SCAN_BATCH_SIZE)
+      return;
+    auto entry = *iterator;
+    if (has_high_key_) {
+      int cmp = comparator_(entry.first, high_key_);
+      if (cmp > 0 || (cmp == 0 && !high_inclusive_))
+        break;
+    }
+    entries_.push_back(entry);
+  }
+  done_ = true;
+}
+
 /*
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(IndexMetadata *metadata,
                                      BufferPoolManager *buffer_pool_manager,
-                                     page_id_t root_page_id)
-    : Index(metadata), comparator_(metadata->GetKeySchema()),
+                                     page_id_t root_page_id,
+                                     RootCatalog *catalog, bool own_file)
+    : Index(metadata),
+      rid_key_schema_(metadata->IsUnique() &&
+                              metadata->GetIncludeAttrs().empty()
+                          ? nullptr
+                          : AppendRidColumn(
+                                metadata->GetKeySchema(),
+                                metadata->GetIndexColumnCount())),
+      entry_key_schema_(metadata->GetIncludeAttrs().empty()
+                            ? nullptr
+                            : AppendRidColumn(
+                                  metadata->GetEntrySchema(),
+                                  metadata->GetIndexColumnCount())),
+      comparator_(entry_key_schema_ != nullptr ? entry_key_schema_
+                  : rid_key_schema_ != nullptr ? rid_key_schema_
+                                               : metadata->GetKeySchema()),
       container_(metadata->GetName(), buffer_pool_manager, comparator_,
-                 root_page_id) {}
+                 root_page_id, catalog, own_file),
+      filter_lookups_(0), filter_negatives_(0), filter_false_positives_(0),
+      deletes_(0) {
+  if (!metadata->HasFilter())
+    return;
+  filter_.reset(new BloomFilter(FILTER_INITIAL_KEYS));
+  if (root_page_id != INVALID_PAGE_ID)
+    RebuildFilter(FILTER_INITIAL_KEYS);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType BPLUSTREE_INDEX_TYPE::TreeKey(const Tuple &key, int64_t rid) const {
+  KeyType tree_key;
+  if (rid_key_schema_ == nullptr) {
+    tree_key.SetFromKey(key, GetKeySchema());
+    return tree_key;
+  }
+  std::vector<Value> values;
+  for (int i = 0; i < GetKeySchema()->GetColumnCount(); i++)
+    values.push_back(key.GetValue(GetKeySchema(), i));
+  values.push_back(Value(TypeId::BIGINT, rid));
+  tree_key.SetFromKey(Tuple(values, rid_key_schema_), rid_key_schema_);
+  return tree_key;
+}
 
+/*
+ * A search key built by TreeKey lacks the included columns, so it sorts
+ * before the entry of the same key and rid
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
+KeyType BPLUSTREE_INDEX_TYPE::EntryKey(const Tuple &entry, int64_t rid) const {
+  if (entry_key_schema_ == nullptr)
+    return TreeKey(entry, rid);
+  Schema *entry_schema = GetEntrySchema();
+  std::vector<Value> values;
+  for (int i = 0; i < entry_schema->GetColumnCount(); i++) {
+    if (i == GetIndexColumnCount())
+      values.push_back(Value(TypeId::BIGINT, rid));
+    values.push_back(entry.GetValue(entry_schema, i));
+  }
+  KeyType tree_key;
+  tree_key.SetFromKey(Tuple(values, entry_key_schema_), entry_key_schema_);
+  return tree_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Tuple BPLUSTREE_INDEX_TYPE::KeyOf(const Tuple &entry) const {
+  std::vector<Value> values;
+  for (int i = 0; i < GetIndexColumnCount(); i++)
+    values.push_back(entry.GetValue(GetEntrySchema(), i));
+  return Tuple(values, GetKeySchema());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::SameIndexKey(const KeyType &lhs,
+                                        const KeyType &rhs) const {
+  if (rid_key_schema_ == nullptr)
+    return comparator_(lhs, rhs) == 0;
+  int size = KeyPrefixSize(lhs, GetKeySchema());
+  return size == KeyPrefixSize(rhs, GetKeySchema()) &&
+         memcmp(lhs.data, rhs.data, size) == 0;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::FindIndexKey(const KeyType &tree_key, RID &rid) {
+  if (filter_ != nullptr && !FilterMayContain(tree_key))
+    return false;
+  auto iterator = container_.Begin(tree_key);
+  if (iterator.isEnd() || !SameIndexKey((*iterator).first, tree_key))
+    return false;
+  rid = (*iterator).second;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanTreeKeys(const KeyType &low,
+                                        const KeyType &high,
+                                        std::vector<RID> &result) {
+  for (auto iterator = container_.Begin(low);
+       !iterator.isEnd() && comparator_((*iterator).first, high) <= 0;
+       ++iterator)
+    result.push_back((*iterator).second);
+}
+
+/*
+ * The filter holds the index key bytes of the tree keys, rid and included
+ * columns left out, so every entry of a key sets the same bits
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::FilterMayContain(const KeyType &tree_key) {
+  std::lock_guard<std::mutex> guard(filter_latch_);
+  return filter_->MayContain(tree_key.data,
+                             KeyPrefixSize(tree_key, GetKeySchema()));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::FilterRulesOut(const KeyType &tree_key) {
+  if (filter_ == nullptr)
+    return false;
+  filter_lookups_++;
+  if (FilterMayContain(tree_key))
+    return false;
+  filter_negatives_++;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::AddToFilter(const KeyType &tree_key) {
+  int size = KeyPrefixSize(tree_key, GetKeySchema());
+  int64_t capacity;
+  {
+    std::lock_guard<std::mutex> guard(filter_latch_);
+    // the walk of a rebuild may have passed the key already
+    if (rebuilding_filter_)
+      filter_added_keys_.push_back(tree_key);
+    // another entry of the key is in already
+    if (filter_->MayContain(tree_key.data, size))
+      return;
+    // a rebuild under way is sized for the keys it finds, the current filter
+    // may run over its capacity until then
+    if (rebuilding_filter_ ||
+        filter_->GetKeyCount() < filter_->GetCapacity()) {
+      filter_->Add(tree_key.data, size);
+      return;
+    }
+    capacity = filter_->GetCapacity() * 2;
+  }
+  // the tree already holds the key, the new filter picks it up
+  RebuildFilter(capacity);
+}
+
+/*
+ * The tree is walked without filter_latch_, lookups keep using the current
+ * filter meanwhile. Keys added during the walk are remembered and go into
+ * the new filter before it replaces the current one. Starts over at twice
+ * the size whenever the tree turns out to hold more keys, which at most
+ * doubles the work of the last pass
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::RebuildFilter(int64_t capacity) {
+  {
+    std::lock_guard<std::mutex> guard(filter_latch_);
+    // one rebuild at a time, the running one gets the keys added meanwhile
+    if (rebuilding_filter_)
+      return;
+    rebuilding_filter_ = true;
+  }
+  std::unique_ptr<BloomFilter> filter(new BloomFilter());
+  bool full;
+  do {
+    filter->Reset(capacity);
+    full = false;
+    KeyType last_key;
+    bool first = true;
+    for (auto iterator = container_.Begin(); !iterator.isEnd(); ++iterator) {
+      const KeyType &key = (*iterator).first;
+      if (!first && SameIndexKey(last_key, key))
+        continue;
+      if (filter->GetKeyCount() == filter->GetCapacity()) {
+        full = true;
+        break;
+      }
+      filter->Add(key.data, KeyPrefixSize(key, GetKeySchema()));
+      last_key = key;
+      first = false;
+    }
+    capacity *= 2;
+  } while (full);
+
+  std::lock_guard<std::mutex> guard(filter_latch_);
+  for (auto &key : filter_added_keys_)
+    filter->Add(key.data, KeyPrefixSize(key, GetKeySchema()));
+  filter_added_keys_.clear();
+  filter_ = std::move(filter);
+  rebuilding_filter_ = false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid,
                                        Transaction *transaction) {
+  // the tree tells the entries of a unique index with included columns
+  // apart by rid, keep the first one of a key
+  RID found;
+  if (GetMetadata()->IsUnique() && entry_key_schema_ != nullptr &&
+      FindIndexKey(TreeKey(KeyOf(key), MIN_RID), found))
+    return false;
   // construct insert index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  KeyType index_key = EntryKey(key, rid.Get());
+  if (!container_.Insert(index_key, rid, transaction))
+    return false;
+  if (filter_ != nullptr)
+    AddToFilter(index_key);
+  return true;
+}
 
-  container_.Insert(index_key, rid, transaction);
+/*
+ * The tree keys go in in key order, so consecutive inserts share the pages
+ * of their path and appends past the largest key take the right-most leaf
+ * fast path. A stable sort keeps the first rid of a key in a unique index
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::InsertEntries(
+    const std::vector<std::pair<Tuple, RID>> &entries,
+    Transaction *transaction) {
+  // the entries of a key differ by rid there, insert in the order given
+  if (GetMetadata()->IsUnique() && entry_key_schema_ != nullptr) {
+    for (auto &entry : entries)
+      InsertEntry(entry.first, entry.second, transaction);
+    return;
+  }
+  std::vector<std::pair<KeyType, ValueType>> items(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    items[i].first = EntryKey(entries[i].first, entries[i].second.Get());
+    items[i].second = entries[i].second;
+  }
+  std::stable_sort(items.begin(), items.end(),
+                   [this](const std::pair<KeyType, ValueType> &a,
+                          const std::pair<KeyType, ValueType> &b) {
+                     return comparator_(a.first, b.first) < 0;
+                   });
+  for (auto &item : items) {
+    container_.Insert(item.first, item.second, transaction);
+    if (filter_ != nullptr)
+      AddToFilter(item.first);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key,
+void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid,
                                        Transaction *transaction) {
   // construct delete index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  KeyType index_key = EntryKey(key, rid.Get());
+  // a unique index may hold the key for another rid
+  if (rid_key_schema_ == nullptr) {
+    std::vector<RID> rids;
+    container_.GetValue(index_key, rids, transaction);
+    if (rids.empty() || !(rids[0] == rid))
+      return;
+  }
 
   container_.Remove(index_key, transaction);
+  deletes_++;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::FindKey(const Tuple &key, RID &rid,
+                                   Transaction *transaction) {
+  return FindIndexKey(TreeKey(key, MIN_RID), rid);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> &result,
                                    Transaction *transaction) {
   // construct scan index key
-  KeyType index_key;
-  index_key.SetFromKey(key);
+  KeyType index_key = TreeKey(key, MIN_RID);
+  if (FilterRulesOut(index_key))
+    return;
+
+  size_t found = result.size();
+  if (rid_key_schema_ == nullptr)
+    container_.GetValue(index_key, result, transaction);
+  else
+    ScanTreeKeys(index_key, TreeKey(key, MAX_RID), result);
+  if (filter_ != nullptr && result.size() == found)
+    filter_false_positives_++;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys,
+                                    std::vector<RID> &result,
+                                    Transaction *transaction) {
+  // construct scan index keys, without those the filter rules out. the
+  // filter counters only follow ScanKey
+  std::vector<const Tuple *> probes;
+  std::vector<KeyType> index_keys;
+  for (auto &key : keys) {
+    KeyType index_key = TreeKey(key, MIN_RID);
+    if (filter_ != nullptr && !FilterMayContain(index_key))
+      continue;
+    probes.push_back(&key);
+    index_keys.push_back(index_key);
+  }
+  if (rid_key_schema_ == nullptr) {
+    container_.GetValues(index_keys, result, transaction);
+    return;
+  }
 
-  container_.GetValue(index_key, result, transaction);
+  // one range per distinct key, in key order
+  std::vector<std::pair<KeyType, KeyType>> ranges;
+  for (size_t i = 0; i < probes.size(); i++)
+    ranges.emplace_back(index_keys[i], TreeKey(*probes[i], MAX_RID));
+  std::sort(ranges.begin(), ranges.end(),
+            [this](const std::pair<KeyType, KeyType> &a,
+                   const std::pair<KeyType, KeyType> &b) {
+              return comparator_(a.first, b.first) < 0;
+            });
+  for (size_t i = 0; i < ranges.size(); i++)
+    if (i == 0 || comparator_(ranges[i].first, ranges[i - 1].first) != 0)
+      ScanTreeKeys(ranges[i].first, ranges[i].second, result);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::BulkLoad(
+    const std::vector<std::pair<Tuple, RID>> &entries, double fill_factor) {
+  // convert to tree keys, sort and keep the first rid of every key
+  std::vector<std::pair<KeyType, ValueType>> items(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    items[i].first = EntryKey(entries[i].first, entries[i].second.Get());
+    items[i].second = entries[i].second;
+  }
+  auto less = [this](const std::pair<KeyType, ValueType> &a,
+                     const std::pair<KeyType, ValueType> &b) {
+    return comparator_(a.first, b.first) < 0;
+  };
+  std::stable_sort(items.begin(), items.end(), less);
+  auto last = std::unique(items.begin(), items.end(),
+                          [this](const std::pair<KeyType, ValueType> &a,
+                                 const std::pair<KeyType, ValueType> &b) {
+                            return GetMetadata()->IsUnique()
+                                       ? SameIndexKey(a.first, b.first)
+                                       : comparator_(a.first, b.first) == 0;
+                          });
+  items.erase(last, items.end());
+  if (!container_.BulkLoad(items, fill_factor))
+    return false;
+  if (filter_ != nullptr)
+    RebuildFilter(std::max<int64_t>(items.size(), FILTER_INITIAL_KEYS));
+  return true;
 }
+
+/*
+ * With rids appended, an inclusive bound covers every rid of its key and an
+ * open one none of them. A scan of a single key (the covering lookups of an
+ * index with included columns) asks the filter first, like ScanKey
+ */
+INDEX_TEMPLATE_ARGUMENTS
+std::unique_ptr<IndexScanIterator>
+BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low_key, bool low_inclusive,
+                                const Tuple *high_key, bool high_inclusive) {
+  // construct scan index keys
+  KeyType low, high;
+  if (low_key != nullptr)
+    low = TreeKey(*low_key, low_inclusive ? MIN_RID : MAX_RID);
+  if (high_key != nullptr)
+    high = TreeKey(*high_key, high_inclusive ? MAX_RID : MIN_RID);
+  bool point = filter_ != nullptr && low_key != nullptr &&
+               high_key != nullptr && low_inclusive && high_inclusive &&
+               SameIndexKey(low, TreeKey(*high_key, MIN_RID));
+  if (point && FilterRulesOut(low))
+    return std::unique_ptr<IndexScanIterator>(
+        new BPlusTreeIndexScan<KeyType, ValueType, KeyComparator>(
+            &container_, &deletes_, INDEXITERATOR_TYPE(nullptr, 0, nullptr),
+            comparator_, nullptr, -1, nullptr, true, nullptr, true));
+
+  auto iterator =
+      low_key == nullptr ? container_.Begin() : container_.Begin(low);
+  if (point && (iterator.isEnd() || !SameIndexKey((*iterator).first, low)))
+    filter_false_positives_++;
+  return std::unique_ptr<IndexScanIterator>(
+      new BPlusTreeIndexScan<KeyType, ValueType, KeyComparator>(
+          &container_, &deletes_, std::move(iterator), comparator_,
+          entry_key_schema_ != nullptr ? entry_key_schema_ : GetKeySchema(),
+          rid_key_schema_ != nullptr ? GetIndexColumnCount() : -1,
+          low_key == nullptr ? nullptr : &low, low_inclusive,
+          high_key == nullptr ? nullptr : &high, high_inclusive));
+}
+/*
+ * Tree shape from a walk of every level, the histogram from a scan of the
+ * leaves. Buckets hold the same number of entries, the last one may be short
+ */
+INDEX_TEMPLATE_ARGUMENTS
+IndexStats BPLUSTREE_INDEX_TYPE::GetStats(int buckets) {
+  IndexStats stats;
+  stats.levels = container_.GetLevelStats();
+  if (stats.levels.empty())
+    return stats;
+  int64_t depth = (stats.levels.back().entries + buckets - 1) / buckets;
+  if (depth < 1)
+    depth = 1;
+
+  IndexStats::Bucket bucket = {RID(), 0, 0};
+  KeyType last_key;
+  for (auto iterator = container_.Begin(); !iterator.isEnd(); ++iterator) {
+    const auto &item = *iterator;
+    bool new_key = stats.entries == 0 || !SameIndexKey(last_key, item.first);
+    stats.entries++;
+    if (new_key)
+      stats.distinct_keys++;
+    // a key running over into the next bucket counts in both
+    if (new_key || bucket.entries == 0)
+      bucket.distinct_keys++;
+    bucket.entries++;
+    bucket.upper_bound = item.second;
+    if (bucket.entries == depth) {
+      stats.histogram.push_back(bucket);
+      bucket = {RID(), 0, 0};
+    }
+    last_key = item.first;
+  }
+  if (bucket.entries > 0)
+    stats.histogram.push_back(bucket);
+  return stats;
+}
+
+/*
+ * Distinct keys from the entries of the sampled leaves, read from the first
+ * key of each for as many entries as a leaf holds on average
+ */
+INDEX_TEMPLATE_ARGUMENTS
+IndexStats BPLUSTREE_INDEX_TYPE::EstimateStats(int paths) {
+  IndexStats stats;
+  std::vector<KeyType> leaf_keys;
+  stats.levels = container_.SampleLevelStats(paths, leaf_keys);
+  if (stats.levels.empty())
+    return stats;
+  stats.entries = stats.levels.back().entries;
+  stats.distinct_keys = stats.entries;
+  if (GetMetadata()->IsUnique())
+    return stats;
+  int64_t leaf_entries = std::max<int64_t>(
+      stats.entries / std::max(stats.levels.back().pages, 1), 1);
+  int64_t entries = 0, distinct_keys = 0;
+  for (auto &leaf_key : leaf_keys) {
+    KeyType last_key;
+    int64_t read = 0;
+    for (auto iterator = container_.Begin(leaf_key);
+         read < leaf_entries && !iterator.isEnd(); ++iterator, read++) {
+      const auto &item = *iterator;
+      if (read == 0 || !SameIndexKey(last_key, item.first))
+        distinct_keys++;
+      last_key = item.first;
+    }
+    entries += read;
+  }
+  if (entries > 0)
+    stats.distinct_keys = std::max<int64_t>(
+        stats.entries * distinct_keys / entries, 1);
+  return stats;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+FilterStats BPLUSTREE_INDEX_TYPE::GetFilterStats() {
+  FilterStats stats;
+  if (filter_ == nullptr)
+    return stats;
+  {
+    std::lock_guard<std::mutex> guard(filter_latch_);
+    stats.bits = filter_->GetBitCount();
+    stats.keys = filter_->GetKeyCount();
+  }
+  stats.lookups = filter_lookups_;
+  stats.negatives = filter_negatives_;
+  stats.false_positives = filter_false_positives_;
+  return stats;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int BPLUSTREE_INDEX_TYPE::Compact() { return container_.Compact(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::DeleteIndex() { return container_.DeleteTree(); }
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
+template class BPlusTreeIndex<GenericKey<12>, RID, GenericComparator<12>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
+template class BPlusTreeIndex<GenericKey<24>, RID, GenericComparator<24>>;
 template class BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>;
+template class BPlusTreeIndex<GenericKey<48>, RID, GenericComparator<48>>;
 template class BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>;
+template class BPlusTreeIndex<VarlenKey, RID, VarlenComparator>;
+template class BPlusTreeIndex<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class BPlusTreeIndex<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class BPlusTreeIndex<IntegerKey<12>, RID, IntegerComparator<12>>;
+template class BPlusTreeIndex<IntegerKey<16>, RID, IntegerComparator<16>>;
 
 } // namespace scudb
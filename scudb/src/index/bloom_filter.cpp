@@ -0,0 +1,59 @@
+/**
+ * bloom_filter.cpp
+ */
+#include "index/bloom_filter.h"
+
+namespace scudb {
+
+void BloomFilter::Reset(int64_t capacity) {
+  if (capacity < 64)
+    capacity = 64;
+  capacity_ = capacity;
+  keys_ = 0;
+  words_.assign((capacity * BLOOM_FILTER_BITS_PER_KEY + 63) / 64, 0);
+}
+
+/*
+ * The probes are h1 + i * h2 (double hashing), the two halves of one 64 bit
+ * hash are enough for filters of this size
+ */
+void BloomFilter::Add(const char *data, int size) {
+  uint64_t hash = Hash(data, size);
+  uint64_t h1 = hash & 0xffffffff, h2 = (hash >> 32) | 1;
+  uint64_t bits = GetBitCount();
+  for (int i = 0; i < BLOOM_FILTER_HASHES; i++) {
+    uint64_t bit = (h1 + i * h2) % bits;
+    words_[bit / 64] |= uint64_t(1) << (bit % 64);
+  }
+  keys_++;
+}
+
+bool BloomFilter::MayContain(const char *data, int size) const {
+  uint64_t hash = Hash(data, size);
+  uint64_t h1 = hash & 0xffffffff, h2 = (hash >> 32) | 1;
+  uint64_t bits = GetBitCount();
+  for (int i = 0; i < BLOOM_FILTER_HASHES; i++) {
+    uint64_t bit = (h1 + i * h2) % bits;
+    if ((words_[bit / 64] & (uint64_t(1) << (bit % 64))) == 0)
+      return false;
+  }
+  return true;
+}
+
+// FNV-1a, then a final mix so that keys differing in their last bytes (e.g.
+// big endian integers) spread over both halves
+uint64_t BloomFilter::Hash(const char *data, int size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (int i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+} // namespace scudb
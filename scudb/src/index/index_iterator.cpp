@@ -3,6 +3,7 @@
  */
 #include <cassert>
 
+#include "common/exception.h"
 #include "index/index_iterator.h"
 
 namespace scudb {
@@ -12,15 +13,91 @@ namespace scudb {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator() {}
+INDEXITERATOR_TYPE::IndexIterator(Page *page, int index,
+                                  BufferPoolManager *buffer_pool_manager)
+    : leaf_(nullptr), page_(page), index_(index),
+      buffer_pool_manager_(buffer_pool_manager) {
+  if (page_ != nullptr) {
+    leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(page_->GetData());
+    SkipExhaustedLeaves();
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() {}
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other)
+    : leaf_(other.leaf_), page_(other.page_), index_(other.index_),
+      buffer_pool_manager_(other.buffer_pool_manager_) {
+  other.leaf_ = nullptr;
+  other.page_ = nullptr;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE::~IndexIterator() { ReleaseLeaf(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::isEnd() { return leaf_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto INDEXITERATOR_TYPE::operator*()
+    -> decltype(std::declval<B_PLUS_TREE_LEAF_PAGE_TYPE &>().GetItem(0)) {
+  assert(!isEnd());
+  return leaf_->GetItem(index_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  assert(!isEnd());
+  index_++;
+  SkipExhaustedLeaves();
+  return *this;
+}
+
+/*
+ * Move along the leaf chain until index_ points at an entry, leaves emptied
+ * by a concurrent merge are stepped over. Release everything at the end
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (leaf_ != nullptr && index_ >= leaf_->GetSize()) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    Page *next = nullptr;
+    if (next_page_id != INVALID_PAGE_ID) {
+      next = buffer_pool_manager_->FetchPage(next_page_id);
+      if (next == nullptr)
+        throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+    }
+    ReleaseLeaf();
+    if (next == nullptr)
+      return;
+    next->RLatch();
+    page_ = next;
+    leaf_ = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(next->GetData());
+    index_ = 0;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::ReleaseLeaf() {
+  if (page_ == nullptr)
+    return;
+  page_->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+  page_ = nullptr;
+  leaf_ = nullptr;
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
+template class IndexIterator<GenericKey<12>, RID, GenericComparator<12>>;
 template class IndexIterator<GenericKey<16>, RID, GenericComparator<16>>;
+template class IndexIterator<GenericKey<24>, RID, GenericComparator<24>>;
 template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
+template class IndexIterator<GenericKey<48>, RID, GenericComparator<48>>;
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
+template class IndexIterator<VarlenKey, RID, VarlenComparator>;
+template class IndexIterator<IntegerKey<4>, RID, IntegerComparator<4>>;
+template class IndexIterator<IntegerKey<8>, RID, IntegerComparator<8>>;
+template class IndexIterator<IntegerKey<12>, RID, IntegerComparator<12>>;
+template class IndexIterator<IntegerKey<16>, RID, IntegerComparator<16>>;
 
 } // namespace scudb
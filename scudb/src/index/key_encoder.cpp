@@ -0,0 +1,190 @@
+/**
+ * key_encoder.cpp
+ */
+#include <cassert>
+#include <cstring>
+
+#include "index/key_encoder.h"
+#include "type/limits.h"
+
+namespace scudb {
+
+int KeyEncoder::Encode(const Tuple &key, Schema *schema, char *data,
+                       int size) {
+  // bytes per VARCHAR value, unlimited unless the whole key does not fit
+  int budget = size;
+  if (schema->GetUnlinedColumnCount() > 0) {
+    int fixed = 0, length = 0;
+    for (int i = 0; i < schema->GetColumnCount(); i++) {
+      if (schema->IsInlined(i)) {
+        fixed += schema->GetLength(i);
+        continue;
+      }
+      Value value = key.GetValue(schema, i);
+      length += 2;
+      if (!value.IsNull())
+        for (uint32_t j = 0; j + 1 < value.GetLength(); j++)
+          length += value.GetData()[j] == '\0' ? 2 : 1;
+    }
+    if (fixed + length > size)
+      budget = (size - fixed) / schema->GetUnlinedColumnCount();
+  }
+
+  int length = 0;
+  for (int i = 0; i < schema->GetColumnCount(); i++) {
+    if (!schema->IsInlined(i)) {
+      length += EncodeVarchar(key.GetValue(schema, i), data + length, budget);
+      continue;
+    }
+    Value value = key.GetValue(schema, i);
+    int width = schema->GetLength(i);
+    uint64_t bits = 0;
+    switch (schema->GetType(i)) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      bits = static_cast<uint8_t>(value.GetAs<int8_t>()) ^ 0x80;
+      break;
+    case TypeId::SMALLINT:
+      bits = static_cast<uint16_t>(value.GetAs<int16_t>()) ^ 0x8000;
+      break;
+    case TypeId::INTEGER:
+      bits = static_cast<uint32_t>(value.GetAs<int32_t>()) ^ 0x80000000u;
+      break;
+    case TypeId::BIGINT:
+      bits = static_cast<uint64_t>(value.GetAs<int64_t>()) ^ (1ULL << 63);
+      break;
+    case TypeId::DECIMAL: {
+      // negative numbers order the other way round
+      double decimal = value.GetAs<double>();
+      memcpy(&bits, &decimal, sizeof(bits));
+      bits = (bits >> 63) ? ~bits : bits ^ (1ULL << 63);
+      break;
+    }
+    default:
+      bits = value.GetAs<uint64_t>();
+      break;
+    }
+    StoreBigEndian(bits, width, data + length);
+    length += width;
+  }
+  assert(length <= size);
+  return length;
+}
+
+Value KeyEncoder::Decode(const char *data, Schema *schema, int column) {
+  for (int i = 0; i < column; i++)
+    data += schema->IsInlined(i) ? schema->GetLength(i) : VarcharLength(data);
+  if (!schema->IsInlined(column))
+    return DecodeVarchar(data);
+
+  TypeId type = schema->GetType(column);
+  uint64_t bits = LoadBigEndian(data, schema->GetLength(column));
+  switch (type) {
+  case TypeId::BOOLEAN:
+  case TypeId::TINYINT:
+    return Value(type, static_cast<int8_t>(bits ^ 0x80));
+  case TypeId::SMALLINT:
+    return Value(type, static_cast<int16_t>(bits ^ 0x8000));
+  case TypeId::INTEGER:
+    return Value(type, static_cast<int32_t>(bits ^ 0x80000000u));
+  case TypeId::BIGINT:
+    return Value(type, static_cast<int64_t>(bits ^ (1ULL << 63)));
+  case TypeId::DECIMAL: {
+    // the sign bit is set for positive numbers
+    bits = (bits >> 63) ? bits ^ (1ULL << 63) : ~bits;
+    double decimal;
+    memcpy(&decimal, &bits, sizeof(decimal));
+    return Value(type, decimal);
+  }
+  default:
+    return Value(type, bits);
+  }
+}
+
+int KeyEncoder::Length(const char *data, Schema *schema) {
+  int length = 0;
+  for (int i = 0; i < schema->GetColumnCount(); i++)
+    length += schema->IsInlined(i) ? schema->GetLength(i)
+                                   : VarcharLength(data + length);
+  return length;
+}
+
+int KeyEncoder::MaxLength(Schema *schema) {
+  int length = 0;
+  for (int i = 0; i < schema->GetColumnCount(); i++)
+    length += schema->IsInlined(i) ? schema->GetLength(i)
+                                   : schema->GetVariableLength(i) + 2;
+  return length;
+}
+
+void KeyEncoder::EncodeBigint(int64_t value, char *data) {
+  StoreBigEndian(static_cast<uint64_t>(value) ^ (1ULL << 63), sizeof(value),
+                 data);
+}
+
+int64_t KeyEncoder::DecodeBigint(const char *data) {
+  return static_cast<int64_t>(LoadBigEndian(data, sizeof(int64_t)) ^
+                              (1ULL << 63));
+}
+
+void KeyEncoder::StoreBigEndian(uint64_t bits, int size, char *data) {
+  for (int i = size - 1; i >= 0; i--) {
+    data[i] = static_cast<char>(bits & 0xFF);
+    bits >>= 8;
+  }
+}
+
+uint64_t KeyEncoder::LoadBigEndian(const char *data, int size) {
+  uint64_t bits = 0;
+  for (int i = 0; i < size; i++)
+    bits = (bits << 8) | static_cast<uint8_t>(data[i]);
+  return bits;
+}
+
+/*
+ * Escape zero bytes and terminate, in at most size bytes. A value cut short
+ * ends at a whole character so the order of values is kept
+ */
+int KeyEncoder::EncodeVarchar(const Value &value, char *data, int size) {
+  assert(size >= 2);
+  int length = 0;
+  if (value.IsNull()) {
+    data[length++] = '\0';
+    data[length++] = '\0';
+    return length;
+  }
+  const char *str = value.GetData();
+  for (uint32_t i = 0; i + 1 < value.GetLength(); i++) {
+    int need = str[i] == '\0' ? 2 : 1;
+    if (length + need > size - 2)
+      break;
+    data[length++] = str[i];
+    if (str[i] == '\0')
+      data[length++] = '\xFF';
+  }
+  data[length++] = '\0';
+  data[length++] = '\x01';
+  return length;
+}
+
+Value KeyEncoder::DecodeVarchar(const char *data) {
+  if (data[0] == '\0' && data[1] == '\0')
+    return Value(TypeId::VARCHAR, nullptr, PELOTON_VALUE_NULL, false);
+  std::string str;
+  for (int i = 0; data[i] != '\0' || data[i + 1] == '\xFF'; i++) {
+    str += data[i];
+    // skip the escape of a zero byte
+    if (data[i] == '\0')
+      i++;
+  }
+  return Value(TypeId::VARCHAR, str);
+}
+
+int KeyEncoder::VarcharLength(const char *data) {
+  int length = 0;
+  while (data[length] != '\0' || data[length + 1] == '\xFF')
+    length += data[length] == '\0' ? 2 : 1;
+  return length + 2;
+}
+
+} // namespace scudb
@@ -15,23 +15,36 @@ namespace scudb {
  * Init method after creating a new internal page
  * Including set page type, set current size, set page id, set parent id and set
  * max page size
+ * One slot is kept spare so a page can hold max size + 1 pairs right before it
+ * is split
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
-                                          page_id_t parent_id) {}
+                                          page_id_t parent_id) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetMaxSize((PAGE_SIZE - sizeof(BPlusTreeInternalPage)) /
+                 sizeof(MappingType) -
+             1);
+}
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
 KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key;
-  return key;
+  assert(index >= 0 && index < GetSize());
+  return array[index].first;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  assert(index >= 0 && index < GetSize());
+  array[index].first = key;
+}
 
 /*
  * Helper method to find and return array index(or offset), so that its value
@@ -39,7 +52,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
-  return 0;
+  for (int i = 0; i < GetSize(); i++) {
+    if (array[i].second == value)
+      return i;
+  }
+  return -1;
 }
 
 /*
@@ -47,7 +64,42 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return 0; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const {
+  assert(index >= 0 && index < GetSize());
+  return array[index].second;
+}
+
+/*
+ * Helper methods to get/set the right link and the high key
+ */
+INDEX_TEMPLATE_ARGUMENTS
+page_id_t B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetNextPageId() const {
+  return next_page_id_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetHighKey() const {
+  return high_key_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetHighKey(const KeyType &key) {
+  high_key_ = key;
+}
+
+/*
+ * Helper method to decide whether key has moved on to the right sibling
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::IsBeyondHighKey(
+    const KeyType &key, const KeyComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID && comparator(key, high_key_) >= 0;
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -61,7 +113,17 @@ INDEX_TEMPLATE_ARGUMENTS
 ValueType
 B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
                                        const KeyComparator &comparator) const {
-  return INVALID_PAGE_ID;
+  // branch free binary search for the first key > input key, the child
+  // before it covers the input key
+  int base = 1, size = GetSize() - 1;
+  while (size > 1) {
+    int half = size / 2;
+    base = comparator(array[base + half - 1].first, key) <= 0 ? base + half
+                                                               : base;
+    size -= half;
+  }
+  base += size == 1 && comparator(array[base].first, key) <= 0;
+  return array[base - 1].second;
 }
 
 /*****************************************************************************
@@ -76,7 +138,12 @@ B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key,
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(
     const ValueType &old_value, const KeyType &new_key,
-    const ValueType &new_value) {}
+    const ValueType &new_value) {
+  array[0].second = old_value;
+  array[1].first = new_key;
+  array[1].second = new_value;
+  SetSize(2);
+}
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
  * old_value
@@ -86,23 +153,64 @@ INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(
     const ValueType &old_value, const KeyType &new_key,
     const ValueType &new_value) {
-  return 0;
+  int index = ValueIndex(old_value) + 1;
+  assert(index > 0);
+  std::copy_backward(array + index, array + GetSize(),
+                     array + GetSize() + 1);
+  array[index].first = new_key;
+  array[index].second = new_value;
+  IncreaseSize(1);
+  return GetSize();
+}
+
+/*
+ * Append items (sorted, all greater than the keys already present) to the end
+ * of the page and point their children at this page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(
+    const MappingType *items, int size,
+    BufferPoolManager *buffer_pool_manager) {
+  std::copy(items, items + size, array + GetSize());
+  IncreaseSize(size);
+  for (int i = 0; i < size; i++)
+    AdoptChild(items[i].second, buffer_pool_manager);
 }
 
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Remove half of key & value pairs from this page to "recipient" page, the
+ * recipient is linked in right after this page
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(
     BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  int half = GetSize() / 2;
+  recipient->CopyHalfFrom(array + half, GetSize() - half,
+                          buffer_pool_manager);
+  SetSize(half);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->array[0].first);
+}
 
+/*
+ * Take over items as the only content of this page, the first key becomes the
+ * (invalid) separator pushed up into the parent. Adopted children are
+ * re-parented
+ */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
+  std::copy(items, items + size, array);
+  SetSize(size);
+  for (int i = 0; i < size; i++)
+    AdoptChild(array[i].second, buffer_pool_manager);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -113,7 +221,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyHalfFrom(
  * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  assert(index >= 0 && index < GetSize());
+  std::copy(array + index + 1, array + GetSize(), array + index);
+  IncreaseSize(-1);
+}
 
 /*
  * Remove the only key & value pair in internal page and return the value
@@ -121,7 +233,9 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
-  return INVALID_PAGE_ID;
+  assert(GetSize() == 1);
+  SetSize(0);
+  return array[0].second;
 }
 /*****************************************************************************
  * MERGE
@@ -129,15 +243,31 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
 /*
  * Remove all of key & value pairs from this page to "recipient" page, then
  * update relavent key & value pair in its parent page.
+ * The separator key of this page is pulled down from the parent into the
+ * first slot; removing the separator from the parent is left to the caller
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(
     BPlusTreeInternalPage *recipient, int index_in_parent,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  auto *parent = FetchParent(buffer_pool_manager);
+  array[0].first = parent->KeyAt(index_in_parent);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), false);
+
+  recipient->CopyAllFrom(array, GetSize(), buffer_pool_manager);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetSize(0);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
-    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+    MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {
+  std::copy(items, items + size, array + GetSize());
+  for (int i = 0; i < size; i++)
+    AdoptChild(items[i].second, buffer_pool_manager);
+  IncreaseSize(size);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -149,11 +279,26 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyAllFrom(
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
     BPlusTreeInternalPage *recipient,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  auto *parent = FetchParent(buffer_pool_manager);
+  int index = parent->ValueIndex(GetPageId());
+  // the separator comes down with the first child, the next key goes up
+  MappingType pair(parent->KeyAt(index), array[0].second);
+  parent->SetKeyAt(index, array[1].first);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+
+  Remove(0);
+  recipient->CopyLastFrom(pair, buffer_pool_manager);
+  recipient->SetHighKey(array[0].first);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
-    const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+    const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  array[GetSize()] = pair;
+  IncreaseSize(1);
+  AdoptChild(pair.second, buffer_pool_manager);
+}
 
 /*
  * Remove the last key & value pair from this page to head of "recipient"
@@ -162,12 +307,57 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
     BPlusTreeInternalPage *recipient, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  MappingType pair = array[GetSize() - 1];
+  IncreaseSize(-1);
+  recipient->CopyFirstFrom(pair, parent_index, buffer_pool_manager);
+  SetHighKey(pair.first);
+}
 
+/*
+ * The separator at parent_index comes down as the key of the old first child
+ * and the key of the moved pair goes up to replace it
+ */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(
     const MappingType &pair, int parent_index,
-    BufferPoolManager *buffer_pool_manager) {}
+    BufferPoolManager *buffer_pool_manager) {
+  auto *parent = FetchParent(buffer_pool_manager);
+  std::copy_backward(array, array + GetSize(), array + GetSize() + 1);
+  array[1].first = parent->KeyAt(parent_index);
+  array[0].second = pair.second;
+  IncreaseSize(1);
+  parent->SetKeyAt(parent_index, pair.first);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+
+  AdoptChild(pair.second, buffer_pool_manager);
+}
+
+/*
+ * Fetch (pin) the parent page, the caller already holds its latch
+ */
+INDEX_TEMPLATE_ARGUMENTS
+B_PLUS_TREE_INTERNAL_PAGE_TYPE *B_PLUS_TREE_INTERNAL_PAGE_TYPE::FetchParent(
+    BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+}
+
+/*
+ * Point the parent page id of a child moved into this page at this page
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AdoptChild(
+    page_id_t child_id, BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(child_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *child = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  child->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_id, true);
+}
 
 /*****************************************************************************
  * DEBUG
@@ -221,10 +411,24 @@ template class BPlusTreeInternalPage<GenericKey<4>, page_id_t,
                                            GenericComparator<4>>;
 template class BPlusTreeInternalPage<GenericKey<8>, page_id_t,
                                            GenericComparator<8>>;
+template class BPlusTreeInternalPage<GenericKey<12>, page_id_t,
+                                           GenericComparator<12>>;
 template class BPlusTreeInternalPage<GenericKey<16>, page_id_t,
                                            GenericComparator<16>>;
+template class BPlusTreeInternalPage<GenericKey<24>, page_id_t,
+                                           GenericComparator<24>>;
 template class BPlusTreeInternalPage<GenericKey<32>, page_id_t,
                                            GenericComparator<32>>;
+template class BPlusTreeInternalPage<GenericKey<48>, page_id_t,
+                                           GenericComparator<48>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t,
                                            GenericComparator<64>>;
+template class BPlusTreeInternalPage<IntegerKey<4>, page_id_t,
+                                     IntegerComparator<4>>;
+template class BPlusTreeInternalPage<IntegerKey<8>, page_id_t,
+                                     IntegerComparator<8>>;
+template class BPlusTreeInternalPage<IntegerKey<12>, page_id_t,
+                                     IntegerComparator<12>>;
+template class BPlusTreeInternalPage<IntegerKey<16>, page_id_t,
+                                     IntegerComparator<16>>;
 } // namespace scudb
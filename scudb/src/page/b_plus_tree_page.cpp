@@ -9,41 +9,83 @@ namespace scudb {
  * Helper methods to get/set page type
  * Page type enum class is defined in b_plus_tree_page.h
  */
-bool BPlusTreePage::IsLeafPage() const { return false; }
-bool BPlusTreePage::IsRootPage() const { return false; }
-void BPlusTreePage::SetPageType(IndexPageType page_type) {}
+bool BPlusTreePage::IsLeafPage() const {
+  return page_type_ == IndexPageType::LEAF_PAGE;
+}
+bool BPlusTreePage::IsRootPage() const {
+  return parent_page_id_ == INVALID_PAGE_ID;
+}
+void BPlusTreePage::SetPageType(IndexPageType page_type) {
+  page_type_ = page_type;
+}
 
 /*
  * Helper methods to get/set size (number of key/value pairs stored in that
  * page)
  */
-int BPlusTreePage::GetSize() const { return 0; }
-void BPlusTreePage::SetSize(int size) {}
-void BPlusTreePage::IncreaseSize(int amount) {}
+int BPlusTreePage::GetSize() const { return size_; }
+void BPlusTreePage::SetSize(int size) { size_ = size; }
+void BPlusTreePage::IncreaseSize(int amount) { size_ += amount; }
 
 /*
  * Helper methods to get/set max size (capacity) of the page
  */
-int BPlusTreePage::GetMaxSize() const { return 0; }
-void BPlusTreePage::SetMaxSize(int size) {}
+int BPlusTreePage::GetMaxSize() const { return max_size_; }
+void BPlusTreePage::SetMaxSize(int size) { max_size_ = size; }
 
 /*
  * Helper method to get min page size
  * Generally, min page size == max page size / 2
+ * The root is exempt: a root leaf needs one entry, a root internal page needs
+ * two children (otherwise the tree loses a level)
  */
-int BPlusTreePage::GetMinSize() const { return 0; }
+int BPlusTreePage::GetMinSize() const {
+  if (IsRootPage())
+    return IsLeafPage() ? 1 : 2;
+  return IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2;
+}
+
+/*
+ * A page overflows when an insert took it beyond max size (one spare slot
+ * holds the extra entry) and underflows below min size. It is safe for an
+ * operation that can not make it do either
+ */
+bool BPlusTreePage::IsOverflow() const { return size_ > max_size_; }
+bool BPlusTreePage::IsUnderflow() const { return size_ < GetMinSize(); }
+bool BPlusTreePage::IsSafeToInsert() const { return size_ < max_size_; }
+bool BPlusTreePage::IsSafeToRemove() const { return size_ > GetMinSize(); }
+
+bool BPlusTreePage::CanMergeWith(const BPlusTreePage *sibling) const {
+  return size_ + sibling->size_ <= max_size_;
+}
+
+bool BPlusTreePage::IsEmpty() const { return size_ < (IsLeafPage() ? 1 : 2); }
+bool BPlusTreePage::IsSafeToRemoveLazily() const {
+  return size_ > (IsLeafPage() ? 1 : 2);
+}
+bool BPlusTreePage::IsBelowMinSize() const {
+  return size_ < (IsLeafPage() ? max_size_ / 2 : (max_size_ + 1) / 2);
+}
+
+int BPlusTreePage::GetCapacity() const { return max_size_; }
+
+double BPlusTreePage::GetFillFactor() const {
+  return static_cast<double>(size_) / max_size_;
+}
 
 /*
  * Helper methods to get/set parent page id
  */
-page_id_t BPlusTreePage::GetParentPageId() const { return 0; }
-void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {}
+page_id_t BPlusTreePage::GetParentPageId() const { return parent_page_id_; }
+void BPlusTreePage::SetParentPageId(page_id_t parent_page_id) {
+  parent_page_id_ = parent_page_id;
+}
 
 /*
  * Helper methods to get/set self page id
  */
-page_id_t BPlusTreePage::GetPageId() const { return 0; }
-void BPlusTreePage::SetPageId(page_id_t page_id) {}
+page_id_t BPlusTreePage::GetPageId() const { return page_id_; }
+void BPlusTreePage::SetPageId(page_id_t page_id) { page_id_ = page_id; }
 
 /*
  * Helper methods to set lsn
@@ -0,0 +1,292 @@
+/**
+ * b_plus_tree_varlen_internal_page.cpp
+ */
+#include <sstream>
+
+#include "common/exception.h"
+#include "page/b_plus_tree_varlen_internal_page.h"
+
+namespace scudb {
+/*****************************************************************************
+ * HELPER METHODS AND UTILITIES
+ *****************************************************************************/
+/*
+ * Init method after creating a new internal page
+ * Including set page type, set page id, set parent id and set up an empty
+ * slot directory
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::Init(page_id_t page_id,
+                                                 page_id_t parent_id) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  InitHeap();
+}
+
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::SetKeyAt(int index,
+                                                     const KeyType &key) {
+  assert(index >= 0 && index < GetSize());
+  ReplaceKey(index, key);
+}
+
+/*
+ * Helper method to find and return array index(or offset), so that its value
+ * equals to input "value"
+ */
+int B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::ValueIndex(
+    const ValueType &value) const {
+  for (int i = 0; i < GetSize(); i++) {
+    if (ValueAt(i) == value)
+      return i;
+  }
+  return -1;
+}
+
+/*****************************************************************************
+ * LOOKUP
+ *****************************************************************************/
+/*
+ * Find and return the child pointer(page_id) which points to the child page
+ * that contains input "key"
+ * Start the search from the second key(the first key should always be invalid)
+ */
+page_id_t B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::Lookup(
+    const KeyType &key, const KeyComparator &comparator) const {
+  // binary search for the last key <= input key
+  int low = 1, high = GetSize() - 1;
+  while (low <= high) {
+    int mid = low + (high - low) / 2;
+    if (CompareKeyAt(mid, key, comparator) <= 0)
+      low = mid + 1;
+    else
+      high = mid - 1;
+  }
+  return ValueAt(low - 1);
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Populate new root page with old_value + new_key & new_value
+ * NOTE: This method is only called within InsertIntoParent()(b_plus_tree.cpp)
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::PopulateNewRoot(
+    const ValueType &old_value, const KeyType &new_key,
+    const ValueType &new_value) {
+  InsertCell(0, KeyType(), old_value);
+  InsertCell(1, new_key, new_value);
+}
+
+/*
+ * Insert new_key & new_value pair right after the pair with its value ==
+ * old_value
+ * @return:  new size after insertion
+ */
+int B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::InsertNodeAfter(
+    const ValueType &old_value, const KeyType &new_key,
+    const ValueType &new_value) {
+  int index = ValueIndex(old_value) + 1;
+  assert(index > 0);
+  InsertCell(index, new_key, new_value);
+  return GetSize();
+}
+
+/*
+ * Append items (sorted, all greater than the keys already present) to the end
+ * of the page and point their children at this page
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::CopyNFrom(
+    const MappingType *items, int size,
+    BufferPoolManager *buffer_pool_manager) {
+  for (int i = 0; i < size; i++) {
+    InsertCell(GetSize(), items[i].first, items[i].second);
+    AdoptChild(items[i].second, buffer_pool_manager);
+  }
+}
+
+/*****************************************************************************
+ * SPLIT
+ *****************************************************************************/
+/*
+ * Move the upper half of the bytes to "recipient" page, the recipient is
+ * linked in right after this page. Its first key is the separator pushed up
+ * into the parent
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::MoveHalfTo(
+    BPlusTreeInternalPage *recipient,
+    BufferPoolManager *buffer_pool_manager) {
+  int half = SplitIndex();
+  for (int i = half; i < GetSize(); i++) {
+    recipient->InsertCell(recipient->GetSize(), KeyAt(i), ValueAt(i));
+    recipient->AdoptChild(ValueAt(i), buffer_pool_manager);
+  }
+  Truncate(half);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * Remove the key & value pair in internal page according to input index(a.k.a
+ * array offset)
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::Remove(int index) {
+  RemoveCell(index);
+}
+
+/*
+ * Remove the only key & value pair in internal page and return the value
+ * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
+ */
+page_id_t B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
+  assert(GetSize() == 1);
+  page_id_t child = ValueAt(0);
+  RemoveCell(0);
+  return child;
+}
+
+/*****************************************************************************
+ * MERGE
+ *****************************************************************************/
+/*
+ * Remove all of key & value pairs from this page to "recipient" page. The
+ * separator key of this page is pulled down from the parent as the key of
+ * the first entry; removing the separator from the parent is left to the
+ * caller
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::MoveAllTo(
+    BPlusTreeInternalPage *recipient, int index_in_parent,
+    BufferPoolManager *buffer_pool_manager) {
+  auto *parent = FetchParent(buffer_pool_manager);
+  KeyType separator = parent->KeyAt(index_in_parent);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), false);
+
+  for (int i = 0; i < GetSize(); i++) {
+    recipient->InsertCell(recipient->GetSize(), i == 0 ? separator : KeyAt(i),
+                          ValueAt(i));
+    recipient->AdoptChild(ValueAt(i), buffer_pool_manager);
+  }
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  Truncate(0);
+}
+
+/*****************************************************************************
+ * REDISTRIBUTE
+ *****************************************************************************/
+/*
+ * Remove the first key & value pair from this page to tail of "recipient"
+ * page, then update relavent key & value pair in its parent page.
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(
+    BPlusTreeInternalPage *recipient,
+    BufferPoolManager *buffer_pool_manager) {
+  auto *parent = FetchParent(buffer_pool_manager);
+  int index = parent->ValueIndex(GetPageId());
+  // the separator comes down with the first child, the next key goes up
+  MappingType pair(parent->KeyAt(index), ValueAt(0));
+  parent->SetKeyAt(index, KeyAt(1));
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+
+  RemoveCell(0);
+  recipient->InsertCell(recipient->GetSize(), pair.first, pair.second);
+  recipient->AdoptChild(pair.second, buffer_pool_manager);
+  recipient->SetHighKey(KeyAt(0));
+}
+
+/*
+ * Remove the last key & value pair from this page to head of "recipient"
+ * page, then update relavent key & value pair in its parent page.
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(
+    BPlusTreeInternalPage *recipient, int parent_index,
+    BufferPoolManager *buffer_pool_manager) {
+  MappingType pair(KeyAt(GetSize() - 1), ValueAt(GetSize() - 1));
+  RemoveCell(GetSize() - 1);
+  recipient->CopyFirstFrom(pair, parent_index, buffer_pool_manager);
+  SetHighKey(pair.first);
+}
+
+/*
+ * The separator at parent_index comes down as the key of the old first child
+ * and the key of the moved pair goes up to replace it
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::CopyFirstFrom(
+    const MappingType &pair, int parent_index,
+    BufferPoolManager *buffer_pool_manager) {
+  auto *parent = FetchParent(buffer_pool_manager);
+  ReplaceKey(0, parent->KeyAt(parent_index));
+  InsertCell(0, KeyType(), pair.second);
+  parent->SetKeyAt(parent_index, pair.first);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+
+  AdoptChild(pair.second, buffer_pool_manager);
+}
+
+/*
+ * Fetch (pin) the parent page, the caller already holds its latch
+ */
+B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE *
+B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::FetchParent(
+    BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  return reinterpret_cast<BPlusTreeInternalPage *>(page->GetData());
+}
+
+/*
+ * Point the parent page id of a child moved into this page at this page
+ */
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::AdoptChild(
+    page_id_t child_id, BufferPoolManager *buffer_pool_manager) {
+  auto *page = buffer_pool_manager->FetchPage(child_id);
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *child = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  child->SetParentPageId(GetPageId());
+  buffer_pool_manager->UnpinPage(child_id, true);
+}
+
+/*****************************************************************************
+ * DEBUG
+ *****************************************************************************/
+void B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::QueueUpChildren(
+    std::queue<BPlusTreePage *> *queue,
+    BufferPoolManager *buffer_pool_manager) {
+  for (int i = 0; i < GetSize(); i++) {
+    auto *page = buffer_pool_manager->FetchPage(ValueAt(i));
+    if (page == nullptr)
+      throw Exception(EXCEPTION_TYPE_INDEX,
+                      "all page are pinned while printing");
+    queue->push(reinterpret_cast<BPlusTreePage *>(page->GetData()));
+  }
+}
+
+std::string B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE::ToString(
+    bool verbose) const {
+  if (GetSize() == 0) {
+    return "";
+  }
+  std::ostringstream os;
+  if (verbose) {
+    os << "[pageId: " << GetPageId() << " parentId: " << GetParentPageId()
+       << "]<" << GetSize() << "> ";
+  }
+  for (int i = verbose ? 0 : 1; i < GetSize(); i++) {
+    if (i > (verbose ? 0 : 1))
+      os << " ";
+    os << std::dec << KeyAt(i).ToString();
+    if (verbose) {
+      os << "(" << ValueAt(i) << ")";
+    }
+  }
+  return os.str();
+}
+
+} // namespace scudb
@@ -0,0 +1,239 @@
+/**
+ * b_plus_tree_varlen_leaf_page.cpp
+ */
+
+#include <sstream>
+
+#include "common/exception.h"
+#include "page/b_plus_tree_varlen_internal_page.h"
+#include "page/b_plus_tree_varlen_leaf_page.h"
+
+namespace scudb {
+
+/*****************************************************************************
+ * HELPER METHODS AND UTILITIES
+ *****************************************************************************/
+
+/**
+ * Init method after creating a new leaf page
+ * Including set page type, set page id/parent id and set up an empty slot
+ * directory
+ */
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::Init(page_id_t page_id,
+                                             page_id_t parent_id) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  InitHeap();
+}
+
+/**
+ * Helper method to find the first index i so that KeyAt(i) >= key, comparing
+ * the keys in place
+ */
+int B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::KeyIndex(
+    const KeyType &key, const KeyComparator &comparator) const {
+  int low = 0, high = GetSize();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (CompareKeyAt(mid, key, comparator) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+/*
+ * Helper method to find and return a copy of the key & value pair associated
+ * with input "index"(a.k.a array offset)
+ */
+std::pair<VarlenKey, RID>
+B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::GetItem(int index) const {
+  return MappingType(KeyAt(index), ValueAt(index));
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+/*
+ * Insert key & value pair into leaf page ordered by key
+ * @return  page size after insertion
+ */
+int B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::Insert(const KeyType &key,
+                                              const ValueType &value,
+                                              const KeyComparator &comparator) {
+  InsertCell(KeyIndex(key, comparator), key, value);
+  return GetSize();
+}
+
+/*
+ * Append items (sorted, all greater than the keys already present) to the end
+ * of the page
+ */
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::CopyNFrom(const MappingType *items,
+                                                  int size,
+                                                  BufferPoolManager *) {
+  for (int i = 0; i < size; i++)
+    InsertCell(GetSize(), items[i].first, items[i].second);
+}
+
+/*****************************************************************************
+ * SPLIT
+ *****************************************************************************/
+/*
+ * Move the upper half of the bytes to "recipient" page, the recipient is
+ * linked in right after this page
+ */
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient,
+                                                   BufferPoolManager *) {
+  int half = SplitIndex();
+  for (int i = half; i < GetSize(); i++)
+    recipient->InsertCell(recipient->GetSize(), KeyAt(i), ValueAt(i));
+  Truncate(half);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
+}
+
+/*
+ * Split for appends: move only the last cell, the one just appended
+ */
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::MoveLastTo(BPlusTreeLeafPage *recipient,
+                                                   BufferPoolManager *) {
+  int last = GetSize() - 1;
+  recipient->InsertCell(0, KeyAt(last), ValueAt(last));
+  Truncate(last);
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  SetNextPageId(recipient->GetPageId());
+  SetHighKey(recipient->KeyAt(0));
+}
+
+/*****************************************************************************
+ * LOOKUP
+ *****************************************************************************/
+/*
+ * For the given key, check to see whether it exists in the leaf page. If it
+ * does, then store its corresponding value in input "value" and return true.
+ * If the key does not exist, then return false
+ */
+bool B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::Lookup(
+    const KeyType &key, ValueType &value,
+    const KeyComparator &comparator) const {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && CompareKeyAt(index, key, comparator) == 0) {
+    value = ValueAt(index);
+    return true;
+  }
+  return false;
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+/*
+ * First look through leaf page to see whether delete key exist or not. If
+ * exist, perform deletion, otherwise return immdiately.
+ * @return   page size after deletion
+ */
+int B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(
+    const KeyType &key, const KeyComparator &comparator) {
+  int index = KeyIndex(key, comparator);
+  if (index < GetSize() && CompareKeyAt(index, key, comparator) == 0)
+    RemoveCell(index);
+  return GetSize();
+}
+
+/*****************************************************************************
+ * MERGE
+ *****************************************************************************/
+/*
+ * Remove all of key & value pairs from this page to "recipient" page, then
+ * update next page id
+ * The emptied page keeps its next page id and high key, so a scan still
+ * holding it steps over it to the right sibling
+ */
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient,
+                                                  int, BufferPoolManager *) {
+  for (int i = 0; i < GetSize(); i++)
+    recipient->InsertCell(recipient->GetSize(), KeyAt(i), ValueAt(i));
+  recipient->SetNextPageId(GetNextPageId());
+  recipient->SetHighKey(GetHighKey());
+  Truncate(0);
+}
+
+/*****************************************************************************
+ * REDISTRIBUTE
+ *****************************************************************************/
+/*
+ * Remove the first key & value pair from this page to "recipient" page, then
+ * update relavent key & value pair in its parent page.
+ */
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::MoveFirstToEndOf(
+    BPlusTreeLeafPage *recipient, BufferPoolManager *buffer_pool_manager) {
+  recipient->InsertCell(recipient->GetSize(), KeyAt(0), ValueAt(0));
+  RemoveCell(0);
+  recipient->SetHighKey(KeyAt(0));
+
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *parent = reinterpret_cast<B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE *>(
+      page->GetData());
+  parent->SetKeyAt(parent->ValueIndex(GetPageId()), KeyAt(0));
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+}
+
+/*
+ * Remove the last key & value pair from this page to "recipient" page, then
+ * update relavent key & value pair in its parent page.
+ */
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::MoveLastToFrontOf(
+    BPlusTreeLeafPage *recipient, int parentIndex,
+    BufferPoolManager *buffer_pool_manager) {
+  MappingType item = GetItem(GetSize() - 1);
+  RemoveCell(GetSize() - 1);
+  recipient->CopyFirstFrom(item, parentIndex, buffer_pool_manager);
+  SetHighKey(item.first);
+}
+
+void B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::CopyFirstFrom(
+    const MappingType &item, int parentIndex,
+    BufferPoolManager *buffer_pool_manager) {
+  InsertCell(0, item.first, item.second);
+
+  auto *page = buffer_pool_manager->FetchPage(GetParentPageId());
+  if (page == nullptr)
+    throw Exception(EXCEPTION_TYPE_INDEX, "out of memory");
+  auto *parent = reinterpret_cast<B_PLUS_TREE_VARLEN_INTERNAL_PAGE_TYPE *>(
+      page->GetData());
+  parent->SetKeyAt(parentIndex, item.first);
+  buffer_pool_manager->UnpinPage(parent->GetPageId(), true);
+}
+
+/*****************************************************************************
+ * DEBUG
+ *****************************************************************************/
+std::string B_PLUS_TREE_VARLEN_LEAF_PAGE_TYPE::ToString(bool verbose) const {
+  if (GetSize() == 0) {
+    return "";
+  }
+  std::ostringstream stream;
+  if (verbose) {
+    stream << "[pageId: " << GetPageId() << " parentId: " << GetParentPageId()
+           << "]<" << GetSize() << "> ";
+  }
+  for (int i = 0; i < GetSize(); i++) {
+    if (i > 0)
+      stream << " ";
+    stream << std::dec << KeyAt(i);
+    if (verbose) {
+      stream << "(" << ValueAt(i) << ")";
+    }
+  }
+  return stream.str();
+}
+
+} // namespace scudb
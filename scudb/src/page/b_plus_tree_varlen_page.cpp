@@ -0,0 +1,260 @@
+/**
+ * b_plus_tree_varlen_page.cpp
+ */
+#include <cstring>
+
+#include "common/rid.h"
+#include "page/b_plus_tree_varlen_page.h"
+
+namespace scudb {
+
+/*****************************************************************************
+ * HELPER METHODS AND UTILITIES
+ *****************************************************************************/
+/*
+ * Empty slot directory and key heap, no high key yet
+ * The capacity keeps room for the largest entry beyond it
+ */
+template <typename ValueType> void BPlusTreeVarlenPage<ValueType>::InitHeap() {
+  SetSize(0);
+  SetMaxSize(PAGE_SIZE - sizeof(BPlusTreeVarlenPage) - MAX_ENTRY_SIZE);
+  next_page_id_ = INVALID_PAGE_ID;
+  free_space_pointer_ = PAGE_SIZE;
+  high_key_offset_ = PAGE_SIZE;
+  high_key_size_ = 0;
+  padding_ = 0;
+}
+
+template <typename ValueType>
+VarlenKey BPlusTreeVarlenPage<ValueType>::GetHighKey() const {
+  VarlenKey key;
+  key.SetFromBytes(reinterpret_cast<const char *>(this) + high_key_offset_,
+                   high_key_size_);
+  return key;
+}
+
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::SetHighKey(const VarlenKey &key) {
+  Release(high_key_offset_, high_key_size_);
+  high_key_offset_ = Allocate(key.data, key.GetSize());
+  high_key_size_ = key.GetSize();
+}
+
+/*
+ * Helper method to decide whether key has moved on to the right sibling
+ */
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::IsBeyondHighKey(
+    const VarlenKey &key, const VarlenComparator &comparator) const {
+  return next_page_id_ != INVALID_PAGE_ID &&
+         comparator.Compare(key.data, key.GetSize(),
+                            reinterpret_cast<const char *>(this) +
+                                high_key_offset_,
+                            high_key_size_) >= 0;
+}
+
+template <typename ValueType>
+VarlenKey BPlusTreeVarlenPage<ValueType>::KeyAt(int index) const {
+  assert(index >= 0 && index < GetSize());
+  VarlenKey key;
+  key.SetFromBytes(KeyData(index), slots_[index].key_size);
+  return key;
+}
+
+template <typename ValueType>
+ValueType BPlusTreeVarlenPage<ValueType>::ValueAt(int index) const {
+  assert(index >= 0 && index < GetSize());
+  ValueType value;
+  memcpy(&value, KeyData(index) + slots_[index].key_size, sizeof(ValueType));
+  return value;
+}
+
+/*****************************************************************************
+ * OCCUPANCY
+ *****************************************************************************/
+/*
+ * The page overflows once its bytes exceed the capacity and underflows below
+ * half of it. The root follows the rules on entries instead, see GetMinSize
+ */
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::IsOverflow() const {
+  return GetUsedBytes() > GetMaxSize();
+}
+
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::IsUnderflow() const {
+  if (IsRootPage())
+    return GetSize() < GetMinSize();
+  return IsBelowMinSize();
+}
+
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::IsBelowMinSize() const {
+  return GetSize() == 0 || GetUsedBytes() < GetMaxSize() / 2;
+}
+
+/*
+ * Safe no matter how long the key that goes in or out is
+ */
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::IsSafeToInsert() const {
+  return GetUsedBytes() + MAX_ENTRY_SIZE <= GetMaxSize();
+}
+
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::IsSafeToRemove() const {
+  if (IsRootPage())
+    return GetSize() > GetMinSize();
+  return GetUsedBytes() - MAX_ENTRY_SIZE >= GetMaxSize() / 2;
+}
+
+/*
+ * The merged page takes both pages' entries, the separator pulled down from
+ * the parent (internal pages) and one of the high keys
+ */
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::CanMergeWith(
+    const BPlusTreeVarlenPage *sibling) const {
+  return GetUsedBytes() + sibling->GetUsedBytes() + VARLEN_KEY_SIZE <=
+         GetMaxSize();
+}
+
+/*
+ * A separator replaced by a redistribution may be longer than the old one
+ */
+template <typename ValueType>
+bool BPlusTreeVarlenPage<ValueType>::CanSetKeyAt(int index,
+                                                 const VarlenKey &key) const {
+  return GetUsedBytes() - slots_[index].key_size + key.GetSize() <=
+         GetMaxSize();
+}
+
+template <typename ValueType>
+int BPlusTreeVarlenPage<ValueType>::GetCapacity() const {
+  return GetMaxSize() - VARLEN_KEY_SIZE;
+}
+
+template <typename ValueType>
+double BPlusTreeVarlenPage<ValueType>::GetFillFactor() const {
+  return static_cast<double>(GetUsedBytes()) / GetMaxSize();
+}
+
+template <typename ValueType>
+int BPlusTreeVarlenPage<ValueType>::ItemSize(
+    const std::pair<VarlenKey, ValueType> &item) {
+  return sizeof(Slot) + item.first.GetSize() + sizeof(ValueType);
+}
+
+template <typename ValueType>
+int BPlusTreeVarlenPage<ValueType>::GetUsedBytes() const {
+  return GetSize() * sizeof(Slot) + (PAGE_SIZE - free_space_pointer_);
+}
+
+template <typename ValueType>
+int BPlusTreeVarlenPage<ValueType>::GetFreeBytes() const {
+  return free_space_pointer_ - static_cast<int>(sizeof(BPlusTreeVarlenPage)) -
+         GetSize() * static_cast<int>(sizeof(Slot));
+}
+
+/*****************************************************************************
+ * SLOTS AND CELLS
+ *****************************************************************************/
+/*
+ * Put a cell into the heap and its slot at index, slots from index on move
+ * one to the right
+ */
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::InsertCell(int index, const char *key,
+                                                int key_size,
+                                                const ValueType &value) {
+  assert(index >= 0 && index <= GetSize());
+  assert(GetFreeBytes() >=
+         static_cast<int>(sizeof(Slot) + key_size + sizeof(ValueType)));
+  char cell[VARLEN_KEY_SIZE + sizeof(ValueType)];
+  memcpy(cell, key, key_size);
+  memcpy(cell + key_size, &value, sizeof(ValueType));
+  uint16_t offset = Allocate(cell, key_size + sizeof(ValueType));
+  memmove(slots_ + index + 1, slots_ + index,
+          (GetSize() - index) * sizeof(Slot));
+  slots_[index].offset = offset;
+  slots_[index].key_size = key_size;
+  IncreaseSize(1);
+}
+
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::RemoveCell(int index) {
+  assert(index >= 0 && index < GetSize());
+  Release(slots_[index].offset, slots_[index].key_size + sizeof(ValueType));
+  memmove(slots_ + index, slots_ + index + 1,
+          (GetSize() - index - 1) * sizeof(Slot));
+  IncreaseSize(-1);
+}
+
+/*
+ * Swap the key of an entry, the value stays
+ */
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::ReplaceKey(int index,
+                                                const VarlenKey &key) {
+  ValueType value = ValueAt(index);
+  RemoveCell(index);
+  InsertCell(index, key, value);
+}
+
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::Truncate(int index) {
+  while (GetSize() > index)
+    RemoveCell(GetSize() - 1);
+}
+
+/*
+ * Keep the left half at most half of the entry bytes, but at least one entry
+ */
+template <typename ValueType>
+int BPlusTreeVarlenPage<ValueType>::SplitIndex() const {
+  int total = 0;
+  for (int i = 0; i < GetSize(); i++)
+    total += sizeof(Slot) + slots_[i].key_size + sizeof(ValueType);
+  int index = 0, bytes = 0;
+  while (index < GetSize() - 1) {
+    int size = sizeof(Slot) + slots_[index].key_size + sizeof(ValueType);
+    if (index > 0 && bytes + size > total / 2)
+      break;
+    bytes += size;
+    index++;
+  }
+  return index;
+}
+
+template <typename ValueType>
+uint16_t BPlusTreeVarlenPage<ValueType>::Allocate(const char *bytes,
+                                                  int size) {
+  assert(GetFreeBytes() >= size);
+  free_space_pointer_ -= size;
+  memcpy(reinterpret_cast<char *>(this) + free_space_pointer_, bytes, size);
+  return free_space_pointer_;
+}
+
+/*
+ * Shift the heap below the released bytes up over them and fix the offsets
+ * that pointed into the shifted part
+ */
+template <typename ValueType>
+void BPlusTreeVarlenPage<ValueType>::Release(uint16_t offset, int size) {
+  if (size == 0)
+    return;
+  char *data = reinterpret_cast<char *>(this);
+  memmove(data + free_space_pointer_ + size, data + free_space_pointer_,
+          offset - free_space_pointer_);
+  free_space_pointer_ += size;
+  for (int i = 0; i < GetSize(); i++)
+    if (slots_[i].offset < offset)
+      slots_[i].offset += size;
+  if (high_key_offset_ < offset)
+    high_key_offset_ += size;
+}
+
+template class BPlusTreeVarlenPage<RID>;
+template class BPlusTreeVarlenPage<page_id_t>;
+
+} // namespace scudb
@@ -0,0 +1,44 @@
+/**
+ * free_space_page.cpp
+ */
+
+#include <cassert>
+
+#include "page/free_space_page.h"
+
+namespace scudb {
+
+page_id_t FreeSpacePage::GetNextPageId() {
+  return *reinterpret_cast<page_id_t *>(GetData());
+}
+
+void FreeSpacePage::SetNextPageId(page_id_t next_page_id) {
+  memcpy(GetData(), &next_page_id, 4);
+}
+
+int FreeSpacePage::GetEntryCount() {
+  return *reinterpret_cast<int *>(GetData() + 4);
+}
+
+void FreeSpacePage::SetEntryCount(int entry_count) {
+  memcpy(GetData() + 4, &entry_count, 4);
+}
+
+void FreeSpacePage::GetEntry(int index, page_id_t &page_id,
+                             int32_t &free_bytes) {
+  assert(index >= 0 && index < GetEntryCount());
+  int offset = 8 + index * 8;
+  page_id = *reinterpret_cast<page_id_t *>(GetData() + offset);
+  free_bytes = *reinterpret_cast<int32_t *>(GetData() + offset + 4);
+}
+
+void FreeSpacePage::SetEntry(int index, page_id_t page_id,
+                             int32_t free_bytes) {
+  assert(index >= 0 && index <= GetEntryCount() && index < MAX_ENTRY_COUNT);
+  int offset = 8 + index * 8;
+  memcpy(GetData() + offset, &page_id, 4);
+  memcpy(GetData() + offset + 4, &free_bytes, 4);
+  if (index == GetEntryCount())
+    SetEntryCount(index + 1);
+}
+} // namespace scudb
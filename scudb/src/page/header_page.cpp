@@ -13,10 +13,15 @@ namespace scudb {
  */
 bool HeaderPage::InsertRecord(const std::string &name,
                               const page_id_t root_id) {
-  assert(name.length() < 32);
   assert(root_id > INVALID_PAGE_ID);
+  // the name does not fit a record
+  if (name.length() >= 32)
+    return false;
 
   int record_num = GetRecordCount();
+  // the page is full
+  if (record_num >= MAX_RECORD_COUNT)
+    return false;
   int offset = 4 + record_num * 36;
   // check for duplicate name
   if (FindRecord(name) != -1)
@@ -73,6 +78,13 @@ bool HeaderPage::GetRootId(const std::string &name, page_id_t &root_id) {
   return true;
 }
 
+void HeaderPage::GetRecord(int index, std::string &name, page_id_t &root_id) {
+  assert(index >= 0 && index < GetRecordCount());
+  int offset = 4 + index * 36;
+  name = reinterpret_cast<char *>(GetData() + offset);
+  root_id = *reinterpret_cast<page_id_t *>(GetData() + offset + 32);
+}
+
 /**
  * helper functions
  */
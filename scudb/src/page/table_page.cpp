@@ -2,6 +2,7 @@
  * header_page.cpp
  */
 
+#include <algorithm>
 #include <cassert>
 
 #include "page/table_page.h"
@@ -43,6 +44,12 @@ void TablePage::SetNextPageId(page_id_t next_page_id) {
   memcpy(GetData() + 12, &next_page_id, 4);
 }
 
+page_id_t TablePage::GetFreeSpacePageId() { return GetPrevPageId(); }
+
+void TablePage::SetFreeSpacePageId(page_id_t free_space_page_id) {
+  SetPrevPageId(free_space_page_id);
+}
+
 /**
  * Tuple related
  */
@@ -383,4 +390,11 @@ void TablePage::SetTupleCount(int32_t tuple_count) {
 int32_t TablePage::GetFreeSpaceSize() {
   return GetFreeSpacePointer() - 24 - GetTupleCount() * 8;
 }
+
+int32_t TablePage::GetInsertSpaceSize() {
+  for (int i = 0; i < GetTupleCount(); ++i)
+    if (GetTupleSize(i) == 0) // empty slot
+      return GetFreeSpaceSize();
+  return std::max(GetFreeSpaceSize() - 8, 0);
+}
 } // namespace scudb
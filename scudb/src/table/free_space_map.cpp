@@ -0,0 +1,162 @@
+/**
+ * free_space_map.cpp
+ */
+
+#include "table/free_space_map.h"
+#include "common/exception.h"
+#include "page/free_space_page.h"
+#include "page/table_page.h"
+
+namespace scudb {
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager,
+                           page_id_t first_heap_page_id,
+                           page_id_t first_page_id)
+    : buffer_pool_manager_(buffer_pool_manager),
+      first_heap_page_id_(first_heap_page_id),
+      last_heap_page_id_(first_heap_page_id), first_page_id_(first_page_id) {
+  if (first_page_id_ != INVALID_PAGE_ID)
+    return;
+  auto page = static_cast<FreeSpacePage *>(buffer_pool_manager_->NewPage(
+      first_page_id_, DiskManager::GetFileId(first_heap_page_id_)));
+  if (page == nullptr) {
+    first_page_id_ = INVALID_PAGE_ID;
+    return;
+  }
+  page->Init();
+  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+}
+
+page_id_t FreeSpaceMap::FindPage(int size) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  auto it = by_free_bytes_.lower_bound(std::make_pair(size, INVALID_PAGE_ID));
+  return it == by_free_bytes_.end() ? INVALID_PAGE_ID : it->second;
+}
+
+void FreeSpaceMap::Update(page_id_t page_id, int32_t free_bytes) {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  auto it = heap_pages_.find(page_id);
+  if (it == heap_pages_.end()) {
+    Track(page_id, free_bytes);
+    Store(heap_pages_[page_id].second, page_id, free_bytes);
+    return;
+  }
+  if (it->second.first == free_bytes)
+    return;
+  by_free_bytes_.erase(std::make_pair(it->second.first, page_id));
+  by_free_bytes_.emplace(free_bytes, page_id);
+  it->second.first = free_bytes;
+  Store(it->second.second, page_id, free_bytes);
+}
+
+page_id_t FreeSpaceMap::GetLastHeapPageId() {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  return last_heap_page_id_;
+}
+
+bool FreeSpaceMap::DeletePages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  Load();
+  for (page_id_t page_id : page_ids_)
+    if (!buffer_pool_manager_->DeletePage(page_id))
+      return false;
+  page_ids_.clear();
+  first_page_id_ = INVALID_PAGE_ID;
+  return true;
+}
+
+void FreeSpaceMap::Load() {
+  if (loaded_)
+    return;
+  loaded_ = true;
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page =
+        static_cast<FreeSpacePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr)
+      throw Exception(EXCEPTION_TYPE_CATALOG, "out of memory");
+    page_ids_.push_back(page_id);
+    stored_entries_ += page->GetEntryCount();
+    for (int i = 0; i < page->GetEntryCount(); i++) {
+      page_id_t heap_page_id;
+      int32_t free_bytes;
+      page->GetEntry(i, heap_page_id, free_bytes);
+      Track(heap_page_id, free_bytes);
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+
+  // the pages added to the heap after the stored map last reached the disk,
+  // every page for a heap without one
+  page_id = heap_pages_.empty() ? first_heap_page_id_ : last_heap_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page =
+        static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr)
+      throw Exception(EXCEPTION_TYPE_CATALOG, "out of memory");
+    page->RLatch();
+    int32_t free_bytes = page->GetInsertSpaceSize();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (heap_pages_.find(page_id) == heap_pages_.end()) {
+      Track(page_id, free_bytes);
+      Store(heap_pages_[page_id].second, page_id, free_bytes);
+    }
+    page_id = next_page_id;
+  }
+}
+
+void FreeSpaceMap::Track(page_id_t page_id, int32_t free_bytes) {
+  if (heap_pages_.find(page_id) != heap_pages_.end())
+    return;
+  int slot = static_cast<int>(heap_pages_.size());
+  heap_pages_[page_id] = std::make_pair(free_bytes, slot);
+  by_free_bytes_.emplace(free_bytes, page_id);
+  last_heap_page_id_ = page_id;
+}
+
+/*
+ * A heap page keeps the slot it got when it joined the map, the stored map
+ * only grows at its end. Once an entry could not be stored (no page to be
+ * had) the later ones are not either, the heap pages are then found again
+ * by the next load
+ */
+void FreeSpaceMap::Store(int slot, page_id_t page_id, int32_t free_bytes) {
+  if (first_page_id_ == INVALID_PAGE_ID || slot > stored_entries_)
+    return;
+  size_t index = slot / FreeSpacePage::MAX_ENTRY_COUNT;
+  if (index == page_ids_.size()) {
+    auto last_page = static_cast<FreeSpacePage *>(
+        buffer_pool_manager_->FetchPage(page_ids_.back()));
+    if (last_page == nullptr)
+      return;
+    page_id_t new_page_id;
+    auto new_page = static_cast<FreeSpacePage *>(buffer_pool_manager_->NewPage(
+        new_page_id, DiskManager::GetFileId(first_heap_page_id_)));
+    if (new_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(page_ids_.back(), false);
+      return;
+    }
+    new_page->Init();
+    last_page->SetNextPageId(new_page_id);
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    buffer_pool_manager_->UnpinPage(page_ids_.back(), true);
+    page_ids_.push_back(new_page_id);
+  }
+  auto page = static_cast<FreeSpacePage *>(
+      buffer_pool_manager_->FetchPage(page_ids_[index]));
+  if (page == nullptr)
+    return;
+  page->SetEntry(slot % FreeSpacePage::MAX_ENTRY_COUNT, page_id, free_bytes);
+  buffer_pool_manager_->UnpinPage(page_ids_[index], true);
+  if (slot == stored_entries_)
+    stored_entries_++;
+}
+
+} // namespace scudb
@@ -14,52 +14,109 @@ TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
                      LockManager *lock_manager, LogManager *log_manager,
                      page_id_t first_page_id)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
-      log_manager_(log_manager), first_page_id_(first_page_id) {}
+      log_manager_(log_manager), first_page_id_(first_page_id) {
+  auto first_page = static_cast<TablePage *>(
+      buffer_pool_manager_->FetchPage(first_page_id_));
+  if (first_page == nullptr) { // the map is only kept in memory
+    free_space_map_ =
+        new FreeSpaceMap(buffer_pool_manager_, first_page_id_, INVALID_PAGE_ID);
+    return;
+  }
+  first_page->WLatch();
+  page_id_t free_space_page_id = first_page->GetFreeSpacePageId();
+  free_space_map_ = new FreeSpaceMap(buffer_pool_manager_, first_page_id_,
+                                     free_space_page_id);
+  // a heap from before free space maps gets its first one
+  bool is_dirty = free_space_page_id != free_space_map_->GetFirstPageId();
+  if (is_dirty)
+    first_page->SetFreeSpacePageId(free_space_map_->GetFirstPageId());
+  first_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(first_page_id_, is_dirty);
+}
 
 // create table
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager,
                      LockManager *lock_manager, LogManager *log_manager,
-                     Transaction *txn)
+                     Transaction *txn, int file_id)
     : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager),
       log_manager_(log_manager) {
-  auto first_page =
-      static_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
+  auto first_page = static_cast<TablePage *>(
+      buffer_pool_manager_->NewPage(first_page_id_, file_id));
   assert(first_page != nullptr); // todo: abort table creation?
   first_page->WLatch();
   LOG_DEBUG("new table page created %d", first_page_id_);
 
   first_page->Init(first_page_id_, PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  free_space_map_ =
+      new FreeSpaceMap(buffer_pool_manager_, first_page_id_, INVALID_PAGE_ID);
+  first_page->SetFreeSpacePageId(free_space_map_->GetFirstPageId());
   first_page->WUnlatch();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
 }
 
+/*
+ * A page the free space map knows to have room for the tuple takes it, a
+ * page holding less than the map said is corrected there. The tuple goes
+ * to a new page after the last one if no page has room; the
+ * chain is only followed past the last page of the map when other inserts
+ * added pages meanwhile
+ */
 bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
   if (tuple.size_ + 32 > PAGE_SIZE) { // larger than one page size
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  auto cur_page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
+  page_id_t page_id;
+  while ((page_id = free_space_map_->FindPage(tuple.size_)) !=
+         INVALID_PAGE_ID) {
+    auto page =
+        static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    page->WLatch();
+    bool inserted =
+        page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+    int32_t free_bytes = page->GetInsertSpaceSize();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, inserted);
+    free_space_map_->Update(page_id, free_bytes);
+    if (inserted) {
+      txn->GetWriteSet()->emplace_back(rid, WType::INSERT, Tuple{}, this);
+      return true;
+    }
+  }
+
+  auto cur_page = static_cast<TablePage *>(
+      buffer_pool_manager_->FetchPage(free_space_map_->GetLastHeapPageId()));
   if (cur_page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
+  // the map is told about a page once it is unlatched
+  page_id_t full_page_id = INVALID_PAGE_ID;
+  int32_t free_bytes = 0, full_free_bytes = 0;
   cur_page->WLatch();
   while (!cur_page->InsertTuple(
       tuple, rid, txn, lock_manager_,
       log_manager_)) { // fail to insert due to not enough space
     auto next_page_id = cur_page->GetNextPageId();
     if (next_page_id != INVALID_PAGE_ID) { // valid next page
+      page_id = cur_page->GetPageId();
+      free_bytes = cur_page->GetInsertSpaceSize();
       cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      free_space_map_->Update(page_id, free_bytes);
       cur_page = static_cast<TablePage *>(
           buffer_pool_manager_->FetchPage(next_page_id));
       cur_page->WLatch();
     } else { // create new page
-      auto new_page =
-          static_cast<TablePage *>(buffer_pool_manager_->NewPage(next_page_id));
+      // keep the heap inside the data file of its first page
+      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(
+          next_page_id, DiskManager::GetFileId(first_page_id_)));
       if (new_page == nullptr) {
         cur_page->WUnlatch();
         buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), false);
@@ -72,17 +129,135 @@ bool TableHeap::InsertTuple(const Tuple &tuple, RID &rid, Transaction *txn) {
       cur_page->SetNextPageId(next_page_id);
       new_page->Init(next_page_id, PAGE_SIZE, cur_page->GetPageId(),
                      log_manager_, txn);
+      full_page_id = cur_page->GetPageId();
+      full_free_bytes = cur_page->GetInsertSpaceSize();
       cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
+      buffer_pool_manager_->UnpinPage(full_page_id, true);
       cur_page = new_page;
     }
   }
+  page_id = cur_page->GetPageId();
+  free_bytes = cur_page->GetInsertSpaceSize();
   cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetPageId(), true);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  if (full_page_id != INVALID_PAGE_ID)
+    free_space_map_->Update(full_page_id, full_free_bytes);
+  free_space_map_->Update(page_id, free_bytes);
   txn->GetWriteSet()->emplace_back(rid, WType::INSERT, Tuple{}, this);
   return true;
 }
 
+/*
+ * Same placement as InsertTuple, but a page takes as many of the tuples as
+ * fit under a single latch, in order. The tuples left over once no page of
+ * the map has room fill the last page and then new pages
+ */
+bool TableHeap::InsertTuples(const std::vector<Tuple> &tuples,
+                             std::vector<RID> &rids, Transaction *txn) {
+  rids.assign(tuples.size(), RID());
+  // the tuples still to insert, those larger than a page are left out
+  std::vector<size_t> todo;
+  for (size_t i = 0; i < tuples.size(); i++)
+    if (tuples[i].size_ + 32 <= PAGE_SIZE)
+      todo.push_back(i);
+  bool complete = todo.size() == tuples.size();
+  if (!complete)
+    txn->SetState(TransactionState::ABORTED);
+
+  // fill page with the tuples of todo from next on, return the new next
+  auto fill = [&](TablePage *page, size_t next) {
+    while (next < todo.size() &&
+           page->InsertTuple(tuples[todo[next]], rids[todo[next]], txn,
+                             lock_manager_, log_manager_)) {
+      txn->GetWriteSet()->emplace_back(rids[todo[next]], WType::INSERT,
+                                       Tuple{}, this);
+      next++;
+    }
+    return next;
+  };
+
+  size_t next = 0;
+  page_id_t page_id;
+  while (next < todo.size() &&
+         (page_id = free_space_map_->FindPage(tuples[todo[next]].size_)) !=
+             INVALID_PAGE_ID) {
+    auto page =
+        static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+    page->WLatch();
+    size_t filled = fill(page, next);
+    int32_t free_bytes = page->GetInsertSpaceSize();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, filled > next);
+    free_space_map_->Update(page_id, free_bytes);
+    next = filled;
+  }
+  if (next == todo.size())
+    return complete;
+
+  auto cur_page = static_cast<TablePage *>(
+      buffer_pool_manager_->FetchPage(free_space_map_->GetLastHeapPageId()));
+  if (cur_page == nullptr) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  // the map is told about the pages once they are unlatched
+  std::vector<std::pair<page_id_t, int32_t>> filled_pages;
+  cur_page->WLatch();
+  bool is_dirty = false;
+  while (true) {
+    size_t filled = fill(cur_page, next);
+    is_dirty = is_dirty || filled > next;
+    next = filled;
+    if (next == todo.size())
+      break;
+    page_id = cur_page->GetPageId();
+    auto next_page_id = cur_page->GetNextPageId();
+    filled_pages.emplace_back(page_id, cur_page->GetInsertSpaceSize());
+    if (next_page_id != INVALID_PAGE_ID) { // valid next page
+      cur_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_id, is_dirty);
+      cur_page = static_cast<TablePage *>(
+          buffer_pool_manager_->FetchPage(next_page_id));
+      if (cur_page == nullptr)
+        break;
+      cur_page->WLatch();
+    } else { // create new page
+      // keep the heap inside the data file of its first page
+      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(
+          next_page_id, DiskManager::GetFileId(first_page_id_)));
+      if (new_page == nullptr) {
+        cur_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(page_id, is_dirty);
+        cur_page = nullptr;
+        break;
+      }
+      new_page->WLatch();
+      cur_page->SetNextPageId(next_page_id);
+      new_page->Init(next_page_id, PAGE_SIZE, page_id, log_manager_, txn);
+      cur_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      cur_page = new_page;
+    }
+    is_dirty = false;
+  }
+  if (cur_page != nullptr) {
+    page_id = cur_page->GetPageId();
+    filled_pages.emplace_back(page_id, cur_page->GetInsertSpaceSize());
+    cur_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  } else {
+    txn->SetState(TransactionState::ABORTED);
+    complete = false;
+  }
+  for (auto &filled_page : filled_pages)
+    free_space_map_->Update(filled_page.first, filled_page.second);
+  return complete;
+}
+
 bool TableHeap::MarkDelete(const RID &rid, Transaction *txn) {
   // todo: remove empty page
   auto page = reinterpret_cast<TablePage *>(
@@ -111,8 +286,11 @@ bool TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid,
   page->WLatch();
   bool is_updated = page->UpdateTuple(tuple, old_tuple, rid, txn, lock_manager_,
                                       log_manager_);
+  int32_t free_bytes = page->GetInsertSpaceSize();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetPageId(), is_updated);
+  if (is_updated)
+    free_space_map_->Update(rid.GetPageId(), free_bytes);
   if (is_updated && txn->GetState() != TransactionState::ABORTED)
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
   return is_updated;
@@ -125,8 +303,11 @@ void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   page->WLatch();
   page->ApplyDelete(rid, txn, log_manager_);
   lock_manager_->Unlock(txn, rid);
+  int32_t free_bytes = page->GetInsertSpaceSize();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  // the room of the tuple can be reused now
+  free_space_map_->Update(rid.GetPageId(), free_bytes);
 }
 
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
@@ -155,20 +336,42 @@ bool TableHeap::GetTuple(const RID &rid, Tuple &tuple, Transaction *txn) {
 }
 
 bool TableHeap::DeleteTableHeap() {
-  // todo: real delete
+  int file_id = DiskManager::GetFileId(first_page_id_);
+  if (file_id != 0)
+    return buffer_pool_manager_->DropFile(file_id);
+  // shared data file, delete page by page
+  if (!free_space_map_->DeletePages())
+    return false;
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page =
+        static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr)
+      return false;
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (!buffer_pool_manager_->DeletePage(page_id))
+      return false;
+    page_id = next_page_id;
+  }
   return true;
 }
 
 TableIterator TableHeap::begin(Transaction *txn) {
-  auto page =
-      static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  page->RLatch();
   RID rid;
-  // if failed (no tuple), rid will be the result of default
-  // constructor, which means eof
-  page->GetFirstTupleRid(rid);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(first_page_id_, false);
+  // skip pages whose tuples are all deleted. if every page is empty, rid will
+  // be the result of default constructor, which means eof
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page =
+        static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    page->RLatch();
+    bool found = page->GetFirstTupleRid(rid);
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    page_id = found ? INVALID_PAGE_ID : next_page_id;
+  }
   return TableIterator(this, rid, txn);
 }
 
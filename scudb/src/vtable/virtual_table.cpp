@@ -2,6 +2,7 @@
  * virtual_table.cpp
  */
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 #include <sys/stat.h>
@@ -10,7 +11,6 @@
 #include "common/exception.h"
 #include "common/logger.h"
 #include "common/string_utility.h"
-#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 
 namespace scudb {
@@ -20,14 +20,15 @@ SQLITE_EXTENSION_INIT1
 /* API implementation */
 int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
                sqlite3_vtab **ppVtab, char **pzErr) {
+  if (storage_engine_->IsReadOnly()) {
+    *pzErr = sqlite3_mprintf("vtable storage is opened read-only");
+    return SQLITE_READONLY;
+  }
   BufferPoolManager *buffer_pool_manager =
       storage_engine_->buffer_pool_manager_;
   LockManager *lock_manager = storage_engine_->lock_manager_;
   LogManager *log_manager = storage_engine_->log_manager_;
-
-  // fetch header page from buffer pool
-  HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  RootCatalog *catalog = storage_engine_->catalog_;
 
   // the first three parameter:(1) module name (2) database name (3)table name
   assert(argc >= 4);
@@ -36,23 +37,75 @@ int VtabCreate(sqlite3 *db, void *pAux, int argc, const char *const *argv,
   schema_string = schema_string.substr(1, (schema_string.size() - 2));
   Schema *schema = ParseCreateStatement(schema_string);
 
+  // the storage may already hold the table heap (and maybe its index) when
+  // the table is declared again on an existing database
+  page_id_t table_root_id = INVALID_PAGE_ID;
+  catalog->GetRootId(std::string(argv[2]), table_root_id);
+  // the table heap may need a header page record, its free space map is
+  // found from its first page
+  size_t new_records = table_root_id == INVALID_PAGE_ID;
   // parse arg[4](string that defines table index)
   Index *index = nullptr;
+  bool build_index = false;
   if (argc > 4) {
     std::string index_string(argv[4]);
     index_string = index_string.substr(1, (index_string.size() - 2));
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
         ParseIndexStatement(index_string, std::string(argv[2]), schema);
-    index = ConstructIndex(index_metadata, buffer_pool_manager);
+    // a key cut to its prefix can't tell distinct values apart, a unique
+    // index would take them for duplicates
+    if (index_metadata->IsUnique() && HasPrefixKeys(index_metadata)) {
+      *pzErr = sqlite3_mprintf(
+          "can't create unique index %s, its keys may exceed %d bytes",
+          index_metadata->GetName().c_str(), VARLEN_KEY_SIZE);
+      delete index_metadata;
+      delete schema;
+      return SQLITE_ERROR;
+    }
+    page_id_t index_root_id = INVALID_PAGE_ID;
+    catalog->GetRootId(index_metadata->GetName(), index_root_id);
+    // the index record is written on the first insert, make sure there is
+    // room for it now rather than failing that insert
+    new_records += index_root_id == INVALID_PAGE_ID;
+    build_index =
+        table_root_id != INVALID_PAGE_ID && index_root_id == INVALID_PAGE_ID;
+    index = ConstructIndex(index_metadata, buffer_pool_manager, index_root_id,
+                           catalog, true);
+  }
+  // the header page is a single page, it only holds a few tables
+  if (!catalog->HasRoom(new_records)) {
+    *pzErr = sqlite3_mprintf("can't create table %s, the header page is full",
+                             argv[2]);
+    delete index;
+    delete schema;
+    return SQLITE_ERROR;
+  }
+  // each table heap lives in its own data file, fall back to the shared db
+  // file when the tablespace is full
+  int file_id = 0;
+  if (table_root_id == INVALID_PAGE_ID) {
+    file_id = storage_engine_->disk_manager_->CreateFile();
+    if (file_id < 0)
+      file_id = 0;
   }
   // create table object, allocate memory space
-  VirtualTable *table = new VirtualTable(schema, buffer_pool_manager,
-                                         lock_manager, log_manager, index);
+  VirtualTable *table =
+      new VirtualTable(std::string(argv[2]), schema, buffer_pool_manager,
+                       lock_manager, log_manager, index, table_root_id,
+                       file_id);
 
   // insert table root page info into header page
-  header_page->InsertRecord(std::string(argv[2]), table->GetFirstPageId());
-  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, true);
+  if (table_root_id == INVALID_PAGE_ID &&
+      !catalog->SetRootId(std::string(argv[2]), table->GetFirstPageId())) {
+    *pzErr = sqlite3_mprintf("can't record table %s in the header page",
+                             argv[2]);
+    delete table;
+    return SQLITE_ERROR;
+  }
+  // index over existing rows, bulk load it instead of inserting row by row
+  if (build_index)
+    table->BuildIndex();
 
   // register virtual table within sqlite system
   schema_string = "CREATE TABLE X(" + schema_string + ");";
@@ -75,12 +128,11 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
       storage_engine_->buffer_pool_manager_;
   LockManager *lock_manager = storage_engine_->lock_manager_;
   LogManager *log_manager = storage_engine_->log_manager_;
+  RootCatalog *catalog = storage_engine_->catalog_;
 
-  // Retrieve table root page info from header page
-  HeaderPage *header_page =
-      static_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+  // Retrieve table root page info from header page (catalog)
   page_id_t table_root_id;
-  header_page->GetRootId(std::string(argv[2]), table_root_id);
+  catalog->GetRootId(std::string(argv[2]), table_root_id);
   // parse arg[4](string that defines table index)
   Index *index = nullptr;
   if (argc > 4) {
@@ -89,28 +141,48 @@ int VtabConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
     // create index object, allocate memory space
     IndexMetadata *index_metadata =
         ParseIndexStatement(index_string, std::string(argv[2]), schema);
-    // Retrieve index root page info from header page
-    page_id_t index_root_id;
-    header_page->GetRootId(index_metadata->GetName(), index_root_id);
-    index = ConstructIndex(index_metadata, buffer_pool_manager, index_root_id);
+    // Retrieve index root page info from header page, the index has no record
+    // until its first insert
+    page_id_t index_root_id = INVALID_PAGE_ID;
+    catalog->GetRootId(index_metadata->GetName(), index_root_id);
+    index = ConstructIndex(index_metadata, buffer_pool_manager, index_root_id,
+                           catalog, true);
   }
   VirtualTable *table =
-      new VirtualTable(schema, buffer_pool_manager, lock_manager, log_manager,
-                       index, table_root_id);
+      new VirtualTable(std::string(argv[2]), schema, buffer_pool_manager,
+                       lock_manager, log_manager, index, table_root_id);
 
   // register virtual table within sqlite system
   schema_string = "CREATE TABLE X(" + schema_string + ");";
   assert(sqlite3_declare_vtab(db, schema_string.c_str()) == SQLITE_OK);
 
   *ppVtab = reinterpret_cast<sqlite3_vtab *>(table);
-  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, false);
   return SQLITE_OK;
 }
 
 /*
- * we only support
- * (1) equlity check. e.g select * from foo where a = 1
- * (2) indexed column == predicated column
+ * cost and rows sqlite plans with, on versions that read them
+ */
+static void SetEstimate(sqlite3_index_info *pIdxInfo, double cost,
+                        int64_t rows, bool unique) {
+  pIdxInfo->estimatedCost = cost;
+  // estimatedRows since 3.8.2, idxFlags since 3.9.0
+  if (sqlite3_libversion_number() >= 3008002)
+    pIdxInfo->estimatedRows = rows;
+  if (unique && sqlite3_libversion_number() >= 3009000)
+    pIdxInfo->idxFlags |= SQLITE_INDEX_SCAN_UNIQUE;
+}
+
+/*
+ * we support
+ * (1) equlity check on every indexed column. e.g select * from foo where a = 1
+ * (2) range scan on a single column index, bounded by GT/GE/LT/LE and/or
+ * ordered by the indexed column. e.g select * from foo where a > 1 order by a
+ * constraints on other columns are left to sqlite, which also re-checks the
+ * ones passed to the index
+ * (3) index-only: when every column the statement reads is indexed (or
+ * included in the index) the scan never visits the table heap, and a covering
+ * full index scan beats a table scan. e.g select a from foo where a > 1
  */
 int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
   // LOG_DEBUG("VtabBestIndex");
@@ -118,33 +190,110 @@ int VtabBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
   if (table->GetIndex() == nullptr)
     return SQLITE_OK;
   const std::vector<int> key_attrs = table->GetIndex()->GetKeyAttrs();
-  // make sure indexed column == predicate column
-  // e.g select * from foo where a = 1 and b =2; indexed column must be {a,b}
-  if (pIdxInfo->nConstraint != (int)(key_attrs.size()))
-    return SQLITE_OK;
+  // the index counts the rows, a table scan reads every one of them
+  const IndexStats &stats = table->GetIndexStats();
+  int64_t rows = std::max<int64_t>(stats.entries, 1);
+  SetEstimate(pIdxInfo, rows, rows, false);
 
-  int counter = 0;
-  bool is_index_scan = true;
+  // colUsed (since 3.10.0) has a bit per column read, the last one standing
+  // for every column from the 64th on
+  bool covering = false;
+  if (sqlite3_libversion_number() >= 3010000 &&
+      !HasPrefixKeys(table->GetIndex()->GetMetadata())) {
+    sqlite3_uint64 key_columns = 0;
+    for (int attr : key_attrs)
+      if (attr < 63)
+        key_columns |= 1ULL << attr;
+    for (int attr : table->GetIndex()->GetIncludeAttrs())
+      if (attr < 63)
+        key_columns |= 1ULL << attr;
+    covering = (pIdxInfo->colUsed & ~key_columns) == 0;
+  }
+  // a search down the tree, then a heap fetch per row or, index-only, the
+  // leaves holding the rows
+  double rows_per_leaf = 1;
+  if (covering && !stats.levels.empty())
+    rows_per_leaf = std::max<double>(
+        static_cast<double>(stats.levels.back().entries) /
+            stats.levels.back().pages,
+        1);
+  auto scan_cost = [&](int64_t scan_rows) {
+    return stats.GetHeight() + std::ceil(scan_rows / rows_per_leaf);
+  };
+  int covering_flag = covering ? INDEX_SCAN_COVERING : 0;
+
+  // equality constraint for each indexed column, argv follows key order
+  std::vector<int> eq_constraints(key_attrs.size(), -1);
   for (int i = 0; i < pIdxInfo->nConstraint; i++) {
-    if (pIdxInfo->aConstraint[i].usable == 0)
+    if (pIdxInfo->aConstraint[i].usable == 0 ||
+        pIdxInfo->aConstraint[i].op != SQLITE_INDEX_CONSTRAINT_EQ)
       continue;
-    int item = pIdxInfo->aConstraint[i].iColumn;
-    // if predicate column is part of indexed column
-    if (std::find(key_attrs.begin(), key_attrs.end(), item) !=
-        key_attrs.end()) {
-      // equlity check
-      if (pIdxInfo->aConstraint[i].op != SQLITE_INDEX_CONSTRAINT_EQ) {
-        is_index_scan = false;
-        break;
-      }
-      pIdxInfo->aConstraintUsage[i].argvIndex = (i + 1);
-      counter++;
-    }
+    auto it = std::find(key_attrs.begin(), key_attrs.end(),
+                        pIdxInfo->aConstraint[i].iColumn);
+    if (it != key_attrs.end())
+      eq_constraints[it - key_attrs.begin()] = i;
+  }
+  if (std::find(eq_constraints.begin(), eq_constraints.end(), -1) ==
+      eq_constraints.end()) {
+    for (size_t i = 0; i < eq_constraints.size(); i++)
+      pIdxInfo->aConstraintUsage[eq_constraints[i]].argvIndex = i + 1;
+    pIdxInfo->idxNum = INDEX_SCAN_EQ | covering_flag;
+    bool unique = table->GetIndex()->GetMetadata()->IsUnique();
+    int64_t key_rows =
+        unique ? 1
+               : std::max<int64_t>(
+                     rows / std::max<int64_t>(stats.distinct_keys, 1), 1);
+    SetEstimate(pIdxInfo, scan_cost(key_rows), key_rows, unique);
+    return SQLITE_OK;
+  }
+
+  // the key of a multi column index can not be bounded by one column, an
+  // index-only scan still reads all of it
+  if (key_attrs.size() != 1 && !covering)
+    return SQLITE_OK;
+  int low = -1, high = -1;
+  for (int i = 0; i < pIdxInfo->nConstraint && key_attrs.size() == 1; i++) {
+    if (pIdxInfo->aConstraint[i].usable == 0 ||
+        pIdxInfo->aConstraint[i].iColumn != key_attrs[0])
+      continue;
+    unsigned char op = pIdxInfo->aConstraint[i].op;
+    if (low < 0 &&
+        (op == SQLITE_INDEX_CONSTRAINT_GT || op == SQLITE_INDEX_CONSTRAINT_GE))
+      low = i;
+    if (high < 0 &&
+        (op == SQLITE_INDEX_CONSTRAINT_LT || op == SQLITE_INDEX_CONSTRAINT_LE))
+      high = i;
   }
+  // values sharing an indexed prefix are not in order
+  bool ordered = pIdxInfo->nOrderBy == 1 && key_attrs.size() == 1 &&
+                 pIdxInfo->aOrderBy[0].iColumn == key_attrs[0] &&
+                 pIdxInfo->aOrderBy[0].desc == 0 &&
+                 !HasPrefixKeys(table->GetIndex()->GetMetadata());
+  if (low < 0 && high < 0 && !ordered && !covering)
+    return SQLITE_OK;
 
-  if (counter == (int)key_attrs.size() && is_index_scan) {
-    pIdxInfo->idxNum = 1;
+  int idx_num = INDEX_SCAN_RANGE | covering_flag;
+  int argc = 0;
+  // the bound values are not known yet, each bound is taken to keep a tenth
+  // of the rows. A full ordered scan still saves sqlite a sort
+  int64_t range_rows = rows;
+  if (low >= 0) {
+    idx_num |= INDEX_SCAN_LOW;
+    if (pIdxInfo->aConstraint[low].op == SQLITE_INDEX_CONSTRAINT_GT)
+      idx_num |= INDEX_SCAN_LOW_OPEN;
+    pIdxInfo->aConstraintUsage[low].argvIndex = ++argc;
+    range_rows = std::max<int64_t>(range_rows / 10, 1);
+  }
+  if (high >= 0) {
+    idx_num |= INDEX_SCAN_HIGH;
+    if (pIdxInfo->aConstraint[high].op == SQLITE_INDEX_CONSTRAINT_LT)
+      idx_num |= INDEX_SCAN_HIGH_OPEN;
+    pIdxInfo->aConstraintUsage[high].argvIndex = ++argc;
+    range_rows = std::max<int64_t>(range_rows / 10, 1);
   }
+  pIdxInfo->orderByConsumed = ordered;
+  pIdxInfo->idxNum = idx_num;
+  SetEstimate(pIdxInfo, scan_cost(range_rows), range_rows, false);
   return SQLITE_OK;
 }
 
@@ -156,14 +305,42 @@ int VtabDisconnect(sqlite3_vtab *pVtab) {
   return SQLITE_OK;
 }
 
+/*
+ * drop table: release the table heap and the index (unlinking their data
+ * files) and remove the table and index records from header page
+ */
+int VtabDestroy(sqlite3_vtab *pVtab) {
+  if (storage_engine_->IsReadOnly())
+    return SQLITE_READONLY;
+  VirtualTable *virtual_table = reinterpret_cast<VirtualTable *>(pVtab);
+  RootCatalog *catalog = storage_engine_->catalog_;
+  Index *index = virtual_table->GetIndex();
+  if (!virtual_table->GetTableHeap()->DeleteTableHeap() ||
+      (index != nullptr && !index->DeleteIndex())) {
+    pVtab->zErrMsg = sqlite3_mprintf("can't release the pages of table %s",
+                                     virtual_table->GetName().c_str());
+    return SQLITE_ERROR;
+  }
+  catalog->DeleteRecord(virtual_table->GetName());
+  // index may not have a root yet
+  if (index != nullptr)
+    catalog->DeleteRecord(index->GetName());
+  return VtabDisconnect(pVtab);
+}
+
 int VtabOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
   // LOG_DEBUG("VtabOpen");
   // if read operation, begin transaction here
-  if (global_transaction_ == nullptr) {
+  bool is_read = global_transaction_ == nullptr;
+  if (is_read) {
     VtabBegin(pVtab);
   }
   VirtualTable *virtual_table = reinterpret_cast<VirtualTable *>(pVtab);
+  // the scan sees the rows inserted so far
+  virtual_table->FlushInserts();
   Cursor *cursor = new Cursor(virtual_table);
+  if (is_read)
+    cursor->SetReadTransaction(GetTransaction());
   *ppCursor = reinterpret_cast<sqlite3_vtab_cursor *>(cursor);
 
   return SQLITE_OK;
@@ -172,8 +349,11 @@ int VtabOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
 int VtabClose(sqlite3_vtab_cursor *cur) {
   // LOG_DEBUG("VtabClose");
   Cursor *cursor = reinterpret_cast<Cursor *>(cur);
-  // if read operation, commit transaction here
-  VtabCommit(nullptr);
+  // if read operation, commit transaction here. A write transaction is left
+  // to sqlite, to commit or roll back
+  if (cursor->GetReadTransaction() != nullptr &&
+      cursor->GetReadTransaction() == GetTransaction())
+    VtabCommit(nullptr);
   delete cursor;
   return SQLITE_OK;
 }
@@ -189,13 +369,32 @@ int VtabFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum, const char *idxStr,
   // LOG_DEBUG("VtabFilter");
   Cursor *cursor = reinterpret_cast<Cursor *>(pVtabCursor);
   Schema *key_schema;
+  cursor->SetCovering(idxNum & INDEX_SCAN_COVERING);
   // if indexed scan
-  if (idxNum == 1) {
+  if (idxNum & INDEX_SCAN_EQ) {
     cursor->SetScanFlag(true);
     // Construct the tuple for point query
     key_schema = cursor->GetKeySchema();
     Tuple scan_tuple = ConstructTuple(key_schema, argv);
-    cursor->ScanKey(scan_tuple);
+    // included columns are read from the leaves a range scan visits
+    if ((idxNum & INDEX_SCAN_COVERING) &&
+        !cursor->GetVirtualTable()->GetIndex()->GetIncludeAttrs().empty())
+      cursor->ScanRange(&scan_tuple, true, &scan_tuple, true);
+    else
+      cursor->ScanKey(scan_tuple);
+  } else if (idxNum & INDEX_SCAN_RANGE) {
+    cursor->SetScanFlag(true);
+    // Construct the tuples for the bounds, in the order VtabBestIndex used
+    key_schema = cursor->GetKeySchema();
+    Tuple low_tuple, high_tuple;
+    if (idxNum & INDEX_SCAN_LOW)
+      low_tuple = ConstructTuple(key_schema, argv++);
+    if (idxNum & INDEX_SCAN_HIGH)
+      high_tuple = ConstructTuple(key_schema, argv);
+    cursor->ScanRange((idxNum & INDEX_SCAN_LOW) ? &low_tuple : nullptr,
+                      !(idxNum & INDEX_SCAN_LOW_OPEN),
+                      (idxNum & INDEX_SCAN_HIGH) ? &high_tuple : nullptr,
+                      !(idxNum & INDEX_SCAN_HIGH_OPEN));
   }
   return SQLITE_OK;
 }
@@ -254,12 +453,29 @@ int VtabRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
   return SQLITE_OK;
 }
 
+// a write would give a key of a unique index a second row, the row is left
+// out and sqlite aborts the statement
+static int UniqueConstraintFailed(sqlite3_vtab *pVTab) {
+  VirtualTable *table = reinterpret_cast<VirtualTable *>(pVTab);
+  sqlite3_free(pVTab->zErrMsg);
+  pVTab->zErrMsg = sqlite3_mprintf("UNIQUE constraint failed: %s",
+                                   table->GetIndex()->GetName().c_str());
+  return SQLITE_CONSTRAINT_UNIQUE;
+}
+
 int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
                sqlite_int64 *pRowid) {
   // LOG_DEBUG("VtabUpdate");
+  if (storage_engine_->IsReadOnly())
+    return SQLITE_READONLY;
   VirtualTable *table = reinterpret_cast<VirtualTable *>(pVTab);
+  // sqlite begins a transaction before the write, unless a cursor that read
+  // for it committed that transaction already
+  if (GetTransaction() == nullptr)
+    VtabBegin(pVTab);
   // The single row with rowid equal to argv[0] is deleted
   if (argc == 1) {
+    table->FlushInserts();
     const RID rid(sqlite3_value_int64(argv[0]));
     // delete entry from index
     table->DeleteEntry(rid);
@@ -272,11 +488,9 @@ int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
   else if (argc > 1 && sqlite3_value_type(argv[0]) == SQLITE_NULL) {
     Schema *schema = table->GetSchema();
     Tuple tuple = ConstructTuple(schema, (argv + 2));
-    // insert into table heap
-    RID rid;
-    table->InsertTuple(tuple, rid);
-    // insert into index
-    table->InsertEntry(tuple, rid);
+    // insert into table heap and index, in batches
+    if (!table->BufferInsert(tuple))
+      return UniqueConstraintFailed(pVTab);
   }
   // The row with rowid argv[0] is updated with new values in argv[2] and
   // following parameters.
@@ -284,6 +498,9 @@ int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
     Schema *schema = table->GetSchema();
     Tuple tuple = ConstructTuple(schema, (argv + 2));
     RID rid(sqlite3_value_int64(argv[0]));
+    table->FlushInserts();
+    if (table->HasKeyConflict(tuple, rid))
+      return UniqueConstraintFailed(pVTab);
     // for update, index always delete and insert
     // because you have no clue key has been updated or not
     table->DeleteEntry(rid);
@@ -301,13 +518,25 @@ int VtabUpdate(sqlite3_vtab *pVTab, int argc, sqlite3_value **argv,
 
 int VtabBegin(sqlite3_vtab *pVTab) {
   // LOG_DEBUG("VtabBegin");
-  // create new transaction(write operation will call this method)
-  global_transaction_ = storage_engine_->transaction_manager_->Begin();
+  // create new transaction(write operation will call this method), a write
+  // that starts while a cursor reads continues its transaction
+  if (global_transaction_ == nullptr)
+    global_transaction_ = storage_engine_->transaction_manager_->Begin();
   return SQLITE_OK;
 }
 
 int VtabCommit(sqlite3_vtab *pVTab) {
   // LOG_DEBUG("VtabCommit");
+  // a read commits as well, the rows held back by any table are part of the
+  // transaction
+  for (auto &virtual_table : virtual_tables_)
+    virtual_table.second->FlushInserts();
+  // merge the index pages the deletes of a write left underfull. Done here
+  // rather than by a compaction thread: the buffer pool is too small to
+  // share with one
+  if (pVTab != nullptr &&
+      reinterpret_cast<VirtualTable *>(pVTab)->GetIndex() != nullptr)
+    reinterpret_cast<VirtualTable *>(pVTab)->GetIndex()->Compact();
   auto transaction = GetTransaction();
   if (transaction == nullptr)
     return SQLITE_OK;
@@ -322,13 +551,82 @@ int VtabCommit(sqlite3_vtab *pVTab) {
   return SQLITE_OK;
 }
 
+int VtabSavepoint(sqlite3_vtab *pVTab, int savepoint) {
+  // the savepoint follows the rows held back so far, a rollback to it undoes
+  // written rows only
+  for (auto &virtual_table : virtual_tables_)
+    virtual_table.second->FlushInserts();
+  auto transaction = GetTransaction();
+  savepoints_.resize(savepoint + 1);
+  if (transaction == nullptr)
+    savepoints_[savepoint] = {INVALID_TXN_ID, 0};
+  else
+    savepoints_[savepoint] = {transaction->GetTransactionId(),
+                              transaction->GetWriteSet()->size()};
+  return SQLITE_OK;
+}
+
+int VtabRelease(sqlite3_vtab *pVTab, int savepoint) {
+  if (static_cast<size_t>(savepoint) < savepoints_.size())
+    savepoints_.resize(savepoint);
+  return SQLITE_OK;
+}
+
+// undo the writes of transaction after its first write_count ones, in the
+// table heaps and their indexes
+static void RollbackWrites(Transaction *transaction, size_t write_count) {
+  auto write_set = transaction->GetWriteSet();
+  if (write_set->size() <= write_count)
+    return;
+  std::deque<WriteRecord> writes(write_set->begin() + write_count,
+                                 write_set->end());
+  for (auto &virtual_table : virtual_tables_)
+    virtual_table.second->DeleteWrittenEntries(writes);
+  storage_engine_->transaction_manager_->RollbackTo(transaction, write_count);
+  for (auto &virtual_table : virtual_tables_)
+    virtual_table.second->RestoreEntries(writes);
+}
+
+int VtabRollbackTo(sqlite3_vtab *pVTab, int savepoint) {
+  for (auto &virtual_table : virtual_tables_)
+    virtual_table.second->DiscardInserts();
+  auto transaction = GetTransaction();
+  if (transaction == nullptr)
+    return SQLITE_OK;
+  // a read commits the transaction, a newer one only wrote after the
+  // savepoint
+  size_t write_count = 0;
+  if (static_cast<size_t>(savepoint) < savepoints_.size() &&
+      savepoints_[savepoint].first == transaction->GetTransactionId())
+    write_count = savepoints_[savepoint].second;
+  RollbackWrites(transaction, write_count);
+  return SQLITE_OK;
+}
+
+int VtabRollback(sqlite3_vtab *pVTab) {
+  // the rows held back by any table were never written, drop them
+  for (auto &virtual_table : virtual_tables_)
+    virtual_table.second->DiscardInserts();
+  savepoints_.clear();
+  auto transaction = GetTransaction();
+  if (transaction == nullptr)
+    return SQLITE_OK;
+  // writes of the transaction before a read committed it stay
+  RollbackWrites(transaction, 0);
+  storage_engine_->transaction_manager_->Abort(transaction);
+  delete transaction;
+  global_transaction_ = nullptr;
+
+  return SQLITE_OK;
+}
+
 sqlite3_module VtableModule = {
-    0,              /* iVersion */
+    2,              /* iVersion */
     VtabCreate,     /* xCreate */
     VtabConnect,    /* xConnect */
     VtabBestIndex,  /* xBestIndex */
     VtabDisconnect, /* xDisconnect */
-    VtabDisconnect, /* xDestroy */
+    VtabDestroy,    /* xDestroy */
     VtabOpen,       /* xOpen - open a cursor */
     VtabClose,      /* xClose - close a cursor */
     VtabFilter,     /* xFilter - configure scan constraints */
@@ -340,26 +638,242 @@ sqlite3_module VtableModule = {
     VtabBegin,      /* xBegin */
     0,              /* xSync */
     VtabCommit,     /* xCommit */
-    0,              /* xRollback */
+    VtabRollback,   /* xRollback */
     0,              /* xFindMethod */
     0,              /* xRename */
-    0,              /* xSavepoint */
-    0,              /* xRelease */
-    0,              /* xRollbackTo */
+    VtabSavepoint,  /* xSavepoint */
+    VtabRelease,    /* xRelease */
+    VtabRollbackTo, /* xRollbackTo */
 };
 
-#ifdef _WIN32
-__declspec(dllexport)
-#endif
-    extern "C" int sqlite3_vtable_init(sqlite3 *db, char **pzErrMsg,
-                                       const sqlite3_api_routines *pApi) {
-  SQLITE_EXTENSION_INIT2(pApi);
+/*
+ * Index statistics: eponymous table-valued functions taking a table name
+ *   select * from index_stats('foo')     -- level, pages, entries, fill_factor
+ *   select * from index_histogram('foo') -- equi-depth key histogram
+ *   select * from index_filter('foo')    -- key filter of point lookups
+ */
+int StatsConnect(sqlite3 *db, void *pAux, int argc, const char *const *argv,
+                 sqlite3_vtab **ppVtab, char **pzErr) {
+  int kind = static_cast<int>(reinterpret_cast<intptr_t>(pAux));
+  int rc = sqlite3_declare_vtab(
+      db, kind == STATS_LEVELS
+              ? "CREATE TABLE X(level INTEGER, pages INTEGER, entries "
+                "INTEGER, fill_factor REAL, table_name HIDDEN);"
+          : kind == STATS_HISTOGRAM
+              ? "CREATE TABLE X(bucket INTEGER, upper_bound TEXT, entries "
+                "INTEGER, distinct_keys INTEGER, table_name HIDDEN);"
+              : "CREATE TABLE X(bits INTEGER, keys INTEGER, "
+                "skipped_lookups INTEGER, false_positive_rate REAL, "
+                "table_name HIDDEN);");
+  if (rc != SQLITE_OK)
+    return rc;
+  StatsTable *table = new StatsTable(db, kind);
+  *ppVtab = reinterpret_cast<sqlite3_vtab *>(table);
+  return SQLITE_OK;
+}
+
+// the table name argument is required
+int StatsBestIndex(sqlite3_vtab *tab, sqlite3_index_info *pIdxInfo) {
+  for (int i = 0; i < pIdxInfo->nConstraint; i++) {
+    if (pIdxInfo->aConstraint[i].usable == 0 ||
+        pIdxInfo->aConstraint[i].op != SQLITE_INDEX_CONSTRAINT_EQ ||
+        pIdxInfo->aConstraint[i].iColumn != STATS_TABLE_NAME_COLUMN)
+      continue;
+    pIdxInfo->aConstraintUsage[i].argvIndex = 1;
+    pIdxInfo->aConstraintUsage[i].omit = 1;
+    pIdxInfo->estimatedCost = 1;
+    return SQLITE_OK;
+  }
+  pIdxInfo->estimatedCost = 1e99;
+  return SQLITE_OK;
+}
+
+int StatsDisconnect(sqlite3_vtab *pVtab) {
+  delete reinterpret_cast<StatsTable *>(pVtab);
+  return SQLITE_OK;
+}
+
+int StatsOpen(sqlite3_vtab *pVtab, sqlite3_vtab_cursor **ppCursor) {
+  StatsCursor *cursor = new StatsCursor();
+  *ppCursor = reinterpret_cast<sqlite3_vtab_cursor *>(cursor);
+  return SQLITE_OK;
+}
+
+int StatsClose(sqlite3_vtab_cursor *cur) {
+  delete reinterpret_cast<StatsCursor *>(cur);
+  return SQLITE_OK;
+}
+
+int StatsFilter(sqlite3_vtab_cursor *pVtabCursor, int idxNum,
+                const char *idxStr, int argc, sqlite3_value **argv) {
+  StatsCursor *cursor = reinterpret_cast<StatsCursor *>(pVtabCursor);
+  StatsTable *stats_table = reinterpret_cast<StatsTable *>(pVtabCursor->pVtab);
+  if (argc != 1) {
+    pVtabCursor->pVtab->zErrMsg = sqlite3_mprintf(
+        "%s requires a table name",
+        stats_table->GetKind() == STATS_LEVELS      ? "index_stats"
+        : stats_table->GetKind() == STATS_HISTOGRAM ? "index_histogram"
+                                                    : "index_filter");
+    return SQLITE_ERROR;
+  }
+  const char *text =
+      reinterpret_cast<const char *>(sqlite3_value_text(argv[0]));
+  std::string name = text == nullptr ? "" : text;
+  auto it = virtual_tables_.find(name);
+  if (it == virtual_tables_.end()) {
+    // sqlite connects a table the first time a statement uses it
+    char *sql = sqlite3_mprintf("SELECT 1 FROM \"%w\"", name.c_str());
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(stats_table->GetDb(), sql, -1, &stmt, nullptr) ==
+        SQLITE_OK)
+      sqlite3_finalize(stmt);
+    sqlite3_free(sql);
+    it = virtual_tables_.find(name);
+  }
+  if (it == virtual_tables_.end()) {
+    pVtabCursor->pVtab->zErrMsg =
+        sqlite3_mprintf("no such vtable: %s", name.c_str());
+    return SQLITE_ERROR;
+  }
+
+  VirtualTable *table = it->second;
+  table->FlushInserts();
+  std::vector<std::vector<Value>> rows;
+  // a table without index has no statistics
+  if (table->GetIndex() == nullptr) {
+    cursor->SetRows(std::move(rows));
+    return SQLITE_OK;
+  }
+  // the filter counters change with every lookup, they are read as they are
+  if (stats_table->GetKind() == STATS_FILTER) {
+    FilterStats filter = table->GetIndex()->GetFilterStats();
+    if (filter.bits > 0)
+      rows.push_back({Value(TypeId::BIGINT, filter.bits),
+                      Value(TypeId::BIGINT, filter.keys),
+                      Value(TypeId::BIGINT, filter.negatives),
+                      Value(TypeId::DECIMAL, filter.GetFalsePositiveRate())});
+    cursor->SetRows(std::move(rows));
+    return SQLITE_OK;
+  }
+  const IndexStats &stats = table->RefreshIndexStats();
+  if (stats_table->GetKind() == STATS_LEVELS) {
+    for (size_t i = 0; i < stats.levels.size(); i++)
+      rows.push_back({Value(TypeId::INTEGER, static_cast<int32_t>(i)),
+                      Value(TypeId::INTEGER, stats.levels[i].pages),
+                      Value(TypeId::BIGINT, stats.levels[i].entries),
+                      Value(TypeId::DECIMAL, stats.levels[i].fill_factor)});
+  } else {
+    // read the bucket bounds in their own transaction outside of a write
+    Transaction *txn = GetTransaction();
+    if (txn == nullptr)
+      txn = storage_engine_->transaction_manager_->Begin();
+    for (size_t i = 0; i < stats.histogram.size(); i++) {
+      const IndexStats::Bucket &bucket = stats.histogram[i];
+      rows.push_back({Value(TypeId::INTEGER, static_cast<int32_t>(i)),
+                      Value(TypeId::VARCHAR,
+                            table->KeyString(bucket.upper_bound, txn)),
+                      Value(TypeId::BIGINT, bucket.entries),
+                      Value(TypeId::BIGINT, bucket.distinct_keys)});
+    }
+    if (txn != GetTransaction()) {
+      storage_engine_->transaction_manager_->Commit(txn);
+      delete txn;
+    }
+  }
+  cursor->SetRows(std::move(rows));
+  return SQLITE_OK;
+}
+
+int StatsNext(sqlite3_vtab_cursor *cur) {
+  reinterpret_cast<StatsCursor *>(cur)->Next();
+  return SQLITE_OK;
+}
+
+int StatsEof(sqlite3_vtab_cursor *cur) {
+  return reinterpret_cast<StatsCursor *>(cur)->isEof();
+}
+
+int StatsColumn(sqlite3_vtab_cursor *cur, sqlite3_context *ctx, int i) {
+  // the table name argument is consumed by StatsFilter
+  if (i == STATS_TABLE_NAME_COLUMN) {
+    sqlite3_result_null(ctx);
+    return SQLITE_OK;
+  }
+  const Value &v = reinterpret_cast<StatsCursor *>(cur)->GetValue(i);
+  switch (v.GetTypeId()) {
+  case TypeId::INTEGER:
+    sqlite3_result_int(ctx, v.GetAs<int32_t>());
+    break;
+  case TypeId::BIGINT:
+    sqlite3_result_int64(ctx, (sqlite3_int64)v.GetAs<int64_t>());
+    break;
+  case TypeId::DECIMAL:
+    sqlite3_result_double(ctx, v.GetAs<double>());
+    break;
+  case TypeId::VARCHAR:
+    sqlite3_result_text(ctx, v.GetData(), -1, SQLITE_TRANSIENT);
+    break;
+  default:
+    return SQLITE_ERROR;
+  } // End of switch
+  return SQLITE_OK;
+}
+
+int StatsRowid(sqlite3_vtab_cursor *cur, sqlite3_int64 *pRowid) {
+  *pRowid = reinterpret_cast<StatsCursor *>(cur)->GetRowid();
+  return SQLITE_OK;
+}
+
+// eponymous-only, no xCreate: exists in every schema under the module name
+sqlite3_module StatsModule = {
+    0,               /* iVersion */
+    0,               /* xCreate */
+    StatsConnect,    /* xConnect */
+    StatsBestIndex,  /* xBestIndex */
+    StatsDisconnect, /* xDisconnect */
+    StatsDisconnect, /* xDestroy */
+    StatsOpen,       /* xOpen - open a cursor */
+    StatsClose,      /* xClose - close a cursor */
+    StatsFilter,     /* xFilter - configure scan constraints */
+    StatsNext,       /* xNext - advance a cursor */
+    StatsEof,        /* xEof - check for end of scan */
+    StatsColumn,     /* xColumn - read data */
+    StatsRowid,      /* xRowid - read data */
+    0,               /* xUpdate */
+    0,               /* xBegin */
+    0,               /* xSync */
+    0,               /* xCommit */
+    0,               /* xRollback */
+    0,               /* xFindMethod */
+    0,               /* xRename */
+    0,               /* xSavepoint */
+    0,               /* xRelease */
+    0,               /* xRollbackTo */
+};
+
+/*
+ * Shared by both extension entry points
+ * read_only: mmap an existing vtable.db, creating/modifying tables is rejected
+ */
+static int InitStorageEngine(sqlite3 *db, char **pzErrMsg, bool read_only) {
   std::string db_file_name = "vtable.db";
   struct stat buffer;
   bool is_file_exist = (stat(db_file_name.c_str(), &buffer) == 0);
+  if (read_only && !is_file_exist) {
+    *pzErrMsg = sqlite3_mprintf("%s does not exist", db_file_name.c_str());
+    return SQLITE_CANTOPEN;
+  }
 
   // init storage engine
-  storage_engine_ = new StorageEngine(db_file_name);
+  storage_engine_ = new StorageEngine(db_file_name, read_only);
+  if (read_only &&
+      storage_engine_->disk_manager_->GetMappedPage(HEADER_PAGE_ID) == nullptr) {
+    delete storage_engine_;
+    storage_engine_ = nullptr;
+    *pzErrMsg = sqlite3_mprintf("%s is not a vtable database",
+                                db_file_name.c_str());
+    return SQLITE_CANTOPEN;
+  }
   // start the logging
   storage_engine_->log_manager_->RunFlushThread();
   // create header page from BufferPoolManager if necessary
@@ -372,9 +886,40 @@ __declspec(dllexport)
   }
 
   int rc = sqlite3_create_module(db, "vtable", &VtableModule, nullptr);
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_module(
+        db, "index_stats", &StatsModule,
+        reinterpret_cast<void *>(static_cast<intptr_t>(STATS_LEVELS)));
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_module(
+        db, "index_histogram", &StatsModule,
+        reinterpret_cast<void *>(static_cast<intptr_t>(STATS_HISTOGRAM)));
+  if (rc == SQLITE_OK)
+    rc = sqlite3_create_module(
+        db, "index_filter", &StatsModule,
+        reinterpret_cast<void *>(static_cast<intptr_t>(STATS_FILTER)));
   return rc;
 }
 
+#ifdef _WIN32
+__declspec(dllexport)
+#endif
+    extern "C" int sqlite3_vtable_init(sqlite3 *db, char **pzErrMsg,
+                                       const sqlite3_api_routines *pApi) {
+  SQLITE_EXTENSION_INIT2(pApi);
+  return InitStorageEngine(db, pzErrMsg, false);
+}
+
+// load with entry point "sqlite3_vtable_readonly_init" for read-only replicas
+#ifdef _WIN32
+__declspec(dllexport)
+#endif
+    extern "C" int sqlite3_vtable_readonly_init(
+        sqlite3 *db, char **pzErrMsg, const sqlite3_api_routines *pApi) {
+  SQLITE_EXTENSION_INIT2(pApi);
+  return InitStorageEngine(db, pzErrMsg, true);
+}
+
 /* Helpers */
 Schema *ParseCreateStatement(const std::string &sql_base) {
   std::string::size_type n;
@@ -441,15 +986,44 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
                                    Schema *schema) {
   std::string::size_type n;
   std::string index_name;
-  std::vector<int> key_attrs;
+  std::vector<int> key_attrs, include_attrs;
   int column_id = -1;
   // prepocess, transform sql string into lower case
   std::transform(sql.begin(), sql.end(), sql.begin(), ::tolower);
+  // optional leading keywords, in any order: unique (indexes hold duplicate
+  // keys otherwise) and bloom (a filter in front of point lookups)
+  bool is_unique = false, has_filter = false;
+  while (true) {
+    if (sql.compare(0, 7, "unique ") == 0) {
+      is_unique = true;
+      sql = sql.substr(7);
+    } else if (sql.compare(0, 6, "bloom ") == 0) {
+      has_filter = true;
+      sql = sql.substr(6);
+    } else {
+      break;
+    }
+  }
   n = sql.find_first_of(' ');
   // NOTE: must use whitespace to seperate index name and indexed column names
   assert(n != std::string::npos);
   index_name = sql.substr(0, n);
   sql = sql.substr(n + 1);
+  // optional trailing list of columns stored in the leaves,
+  // e.g. "foo_a a include (b, c)"
+  std::string include_list;
+  n = sql.find(" include");
+  while (n != std::string::npos && n + 8 < sql.size() && sql[n + 8] != ' ' &&
+         sql[n + 8] != '(')
+    n = sql.find(" include", n + 1);
+  if (n != std::string::npos) {
+    include_list = sql.substr(n + 8);
+    sql = sql.substr(0, n);
+    include_list.erase(
+        std::remove_if(include_list.begin(), include_list.end(),
+                       [](char c) { return c == '(' || c == ')'; }),
+        include_list.end());
+  }
 
   std::vector<std::string> tok = StringUtility::Split(sql, ',');
   // iterate through returned result
@@ -461,9 +1035,30 @@ IndexMetadata *ParseIndexStatement(std::string &sql,
   }
   if ((int)key_attrs.size() > schema->GetColumnCount())
     throw Exception(EXCEPTION_TYPE_INDEX, "can't create index, format error");
+  tok = StringUtility::Split(include_list, ',');
+  for (std::string &t : tok) {
+    StringUtility::Trim(t);
+    column_id = schema->GetColumnID(t);
+    if (column_id != -1 &&
+        std::find(key_attrs.begin(), key_attrs.end(), column_id) ==
+            key_attrs.end() &&
+        std::find(include_attrs.begin(), include_attrs.end(), column_id) ==
+            include_attrs.end())
+      include_attrs.emplace_back(column_id);
+  }
 
-  IndexMetadata *metadata =
-      new IndexMetadata(index_name, table_name, schema, key_attrs);
+  IndexMetadata *metadata = new IndexMetadata(
+      index_name, table_name, schema, key_attrs, is_unique, include_attrs,
+      has_filter);
+  // an entry with included columns is never cut to a prefix, it has to fit
+  // in a key with its values at their declared length
+  if (!include_attrs.empty() &&
+      KeyEncoder::MaxLength(metadata->GetEntrySchema()) + sizeof(int64_t) >
+          VARLEN_KEY_SIZE) {
+    delete metadata;
+    throw Exception(EXCEPTION_TYPE_INDEX,
+                    "can't create index, included columns do not fit");
+  }
 
   // LOG_DEBUG("%s", metadata->ToString().c_str());
   return metadata;
@@ -507,31 +1102,67 @@ Tuple ConstructTuple(Schema *schema, sqlite3_value **argv) {
 // serve the functionality of index factory
 Index *ConstructIndex(IndexMetadata *metadata,
                       BufferPoolManager *buffer_pool_manager,
-                      page_id_t root_id) {
+                      page_id_t root_id, RootCatalog *catalog,
+                      bool own_file) {
+  // keys with varchar attributes are stored at their actual length, included
+  // columns are part of the key of the tree
+  Schema *key_schema = metadata->GetEntrySchema();
+  if (key_schema->GetUnlinedColumnCount() > 0)
+    return new BPlusTreeIndex<VarlenKey, RID, VarlenComparator>(
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
+
   // The size of the key in bytes
-  Schema *key_schema = metadata->GetKeySchema();
   int key_size = key_schema->GetLength();
-  // for each varchar attribute, we assume the largest size is 16 bytes
-  key_size += 16 * key_schema->GetUnlinedColumnCount();
+  // a non-unique index appends the rid to its keys
+  if (!metadata->IsUnique() || !metadata->GetIncludeAttrs().empty())
+    key_size += sizeof(int64_t);
 
+  // INTEGER and BIGINT keys stay GenericKeys too: a memcomparable key is
+  // compared by memcmp, and IntegerComparator only beats it when the build
+  // inlines it (see IntegerKeyBenchmark)
+  // every slot of a page holds a full key, so the closest size class keeps
+  // the fanout up: e.g. an INT key plus rid takes 12 bytes, not 16
   if (key_size <= 4) {
     return new BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>(
-        metadata, buffer_pool_manager, root_id);
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
   } else if (key_size <= 8) {
     return new BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>(
-        metadata, buffer_pool_manager, root_id);
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
+  } else if (key_size <= 12) {
+    return new BPlusTreeIndex<GenericKey<12>, RID, GenericComparator<12>>(
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
   } else if (key_size <= 16) {
     return new BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>(
-        metadata, buffer_pool_manager, root_id);
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
+  } else if (key_size <= 24) {
+    return new BPlusTreeIndex<GenericKey<24>, RID, GenericComparator<24>>(
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
   } else if (key_size <= 32) {
     return new BPlusTreeIndex<GenericKey<32>, RID, GenericComparator<32>>(
-        metadata, buffer_pool_manager, root_id);
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
+  } else if (key_size <= 48) {
+    return new BPlusTreeIndex<GenericKey<48>, RID, GenericComparator<48>>(
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
   } else {
     return new BPlusTreeIndex<GenericKey<64>, RID, GenericComparator<64>>(
-        metadata, buffer_pool_manager, root_id);
+        metadata, buffer_pool_manager, root_id, catalog, own_file);
   }
 }
 
+/*
+ * A key with varchar attributes at their declared length (plus the rid of a
+ * non-unique index) that does not fit in a VarlenKey is cut to a prefix
+ */
+bool HasPrefixKeys(IndexMetadata *metadata) {
+  Schema *key_schema = metadata->GetKeySchema();
+  if (key_schema->GetUnlinedColumnCount() == 0)
+    return false;
+  int key_size = KeyEncoder::MaxLength(key_schema);
+  if (!metadata->IsUnique() || !metadata->GetIncludeAttrs().empty())
+    key_size += sizeof(int64_t);
+  return key_size > VARLEN_KEY_SIZE;
+}
+
 Transaction *GetTransaction() { return global_transaction_; }
 
 } // namespace scudb
@@ -48,4 +48,48 @@ TEST(BufferPoolManagerTest, SampleTest) {
   remove("test.db");
 }
 
+TEST(BufferPoolManagerTest, ReadOnlyMmapTest) {
+  page_id_t temp_page_id;
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(10, disk_manager);
+  for (int i = 0; i < 5; ++i) {
+    auto page = bpm->NewPage(temp_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(true, bpm->UnpinPage(temp_page_id, true));
+    EXPECT_EQ(true, bpm->FlushPage(temp_page_id));
+  }
+  delete bpm;
+  delete disk_manager;
+
+  disk_manager = new DiskManager("test.db", true);
+  EXPECT_TRUE(disk_manager->IsReadOnly());
+  bpm = new BufferPoolManager(2, disk_manager);
+  // more pages than frames can be pinned at once, nothing is evicted
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < 5; ++i) {
+    auto page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    // page is a view into the mapping, not a copy
+    EXPECT_EQ(disk_manager->GetMappedPage(i), page->GetData());
+    snprintf(expected, PAGE_SIZE, "page %d", i);
+    EXPECT_EQ(0, strcmp(page->GetData(), expected));
+  }
+  EXPECT_EQ(bpm->FetchPage(0), bpm->FetchPage(0));
+  // beyond end of file
+  EXPECT_EQ(nullptr, bpm->FetchPage(5));
+  // no writes in read-only mode
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  EXPECT_EQ(false, bpm->DeletePage(0));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
 } // namespace scudb
@@ -0,0 +1,489 @@
+/**
+ * disk_manager_test.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/crc32c.h"
+#include "common/lz4_block.h"
+#include "disk/disk_manager.h"
+#include "gtest/gtest.h"
+
+namespace scudb {
+
+TEST(DiskManagerTest, Crc32cTest) {
+  // check value from RFC 3720 (iSCSI)
+  char zeros[32];
+  memset(zeros, 0, sizeof(zeros));
+  EXPECT_EQ(0x8A9136AAu, Crc32c(zeros, sizeof(zeros)));
+  const char *digits = "123456789";
+  EXPECT_EQ(0xE3069283u, Crc32c(digits, 9));
+  // incremental update gives the same result
+  EXPECT_EQ(0xE3069283u, Crc32c(digits + 4, 5, Crc32c(digits, 4)));
+}
+
+TEST(DiskManagerTest, ChecksumTest) {
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+
+  DiskManager *disk_manager = new DiskManager("test.db", false, true);
+  EXPECT_TRUE(disk_manager->HasChecksum());
+  for (int i = 0; i < 4; ++i) {
+    memset(data, 'a' + i, PAGE_SIZE);
+    disk_manager->WritePage(disk_manager->AllocatePage(), data);
+  }
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(disk_manager->ReadPage(i, buffer));
+    EXPECT_EQ('a' + i, buffer[PAGE_SIZE - 1]);
+  }
+  EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+  delete disk_manager;
+
+  // flip one bit inside page 2
+  std::fstream file("test.db", std::ios::binary | std::ios::in | std::ios::out);
+  file.seekp(2 * (PAGE_SIZE + CHECKSUM_SIZE) + 100);
+  file.put('c' ^ 0x10);
+  file.close();
+
+  disk_manager = new DiskManager("test.db", false, true);
+  EXPECT_TRUE(disk_manager->ReadPage(1, buffer));
+  EXPECT_FALSE(disk_manager->ReadPage(2, buffer));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+
+  // the buffer pool refuses to hand out the bad page and keeps the frame
+  BufferPoolManager *bpm = new BufferPoolManager(1, disk_manager);
+  EXPECT_EQ(nullptr, bpm->FetchPage(2));
+  EXPECT_EQ(2, disk_manager->GetNumChecksumFailures());
+  auto page = bpm->FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ('d', page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  delete bpm;
+  delete disk_manager;
+
+  // the mapping verifies pages as well
+  disk_manager = new DiskManager("test.db", true, true);
+  EXPECT_NE(nullptr, disk_manager->GetMappedPage(1));
+  EXPECT_EQ(nullptr, disk_manager->GetMappedPage(2));
+  EXPECT_EQ(1, disk_manager->GetNumChecksumFailures());
+  delete disk_manager;
+
+  // torn write: the last page lost its tail
+  truncate("test.db", 3 * (PAGE_SIZE + CHECKSUM_SIZE) + PAGE_SIZE / 2);
+  disk_manager = new DiskManager("test.db", false, true);
+  EXPECT_FALSE(disk_manager->ReadPage(3, buffer));
+  EXPECT_TRUE(disk_manager->ReadPage(0, buffer));
+  EXPECT_EQ('a', buffer[0]);
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, Lz4BlockTest) {
+  char data[PAGE_SIZE];
+  char compressed[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+
+  // mostly padding, like a fresh table page
+  memset(data, 0, PAGE_SIZE);
+  strcpy(data + 100, "hello hello hello hello");
+  int len = Lz4Compress(data, PAGE_SIZE, compressed, PAGE_SIZE);
+  EXPECT_LT(0, len);
+  EXPECT_GT(40, len);
+  EXPECT_EQ(PAGE_SIZE, Lz4Decompress(compressed, len, buffer, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+
+  // random bytes do not fit into less than a page
+  srand(7);
+  for (int i = 0; i < PAGE_SIZE; ++i)
+    data[i] = static_cast<char>(rand());
+  EXPECT_EQ(0, Lz4Compress(data, PAGE_SIZE, compressed, PAGE_SIZE - 1));
+
+  // inputs shorter than the minimal match window are stored as literals
+  len = Lz4Compress("abcabc", 6, compressed, PAGE_SIZE);
+  EXPECT_EQ(7, len);
+  EXPECT_EQ(6, Lz4Decompress(compressed, len, buffer, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp("abcabc", buffer, 6));
+
+  // malformed input is rejected instead of overrunning the output
+  memset(data, 'x', PAGE_SIZE);
+  len = Lz4Compress(data, PAGE_SIZE, compressed, PAGE_SIZE);
+  EXPECT_EQ(-1, Lz4Decompress(compressed, len, buffer, PAGE_SIZE / 2));
+  EXPECT_EQ(-1, Lz4Decompress(compressed, len - 1, buffer, PAGE_SIZE));
+}
+
+TEST(DiskManagerTest, CompressionTest) {
+  const int num_pages = 20;
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+
+  DiskManager *disk_manager = new DiskManager("test.db", false, true, true);
+  EXPECT_TRUE(disk_manager->IsCompressed());
+  for (int i = 0; i < num_pages; ++i) {
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_manager->WritePage(disk_manager->AllocatePage(), data);
+  }
+  // page 3 becomes incompressible and has to move to a bigger record
+  srand(3);
+  for (int i = 0; i < PAGE_SIZE; ++i)
+    data[i] = static_cast<char>(rand());
+  disk_manager->WritePage(3, data);
+  memcpy(buffer, data, PAGE_SIZE);
+  memset(data, 0, PAGE_SIZE);
+  EXPECT_TRUE(disk_manager->ReadPage(3, data));
+  EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+  // page 5 shrinks back into its record, page 7 takes the dead one of page 3
+  memset(data, 0, PAGE_SIZE);
+  disk_manager->WritePage(5, data);
+  memset(data, 'y', PAGE_SIZE / 2);
+  for (int i = 0; i < PAGE_SIZE / 2; i += 3)
+    data[i] = static_cast<char>(i);
+  disk_manager->WritePage(7, data);
+  delete disk_manager;
+
+  // zero padding is gone on disk
+  std::ifstream file("test.db", std::ios::binary | std::ios::ate);
+  EXPECT_GT(num_pages * PAGE_SIZE / 2, file.tellg());
+  file.close();
+
+  // page map is rebuilt from the record headers
+  disk_manager = new DiskManager("test.db", false, true, true);
+  EXPECT_EQ(num_pages, disk_manager->AllocatePage());
+  char expected[PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    EXPECT_TRUE(disk_manager->ReadPage(i, buffer));
+    memset(expected, 0, PAGE_SIZE);
+    if (i == 3) {
+      srand(3);
+      for (int j = 0; j < PAGE_SIZE; ++j)
+        expected[j] = static_cast<char>(rand());
+    } else if (i == 7) {
+      memcpy(expected, data, PAGE_SIZE);
+    } else if (i != 5) {
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+    }
+    EXPECT_EQ(0, memcmp(expected, buffer, PAGE_SIZE)) << "page " << i;
+  }
+  // never written page reads as zeros
+  EXPECT_TRUE(disk_manager->ReadPage(num_pages, buffer));
+  EXPECT_EQ(0, buffer[0]);
+  delete disk_manager;
+
+  // compressed files are read through the buffer pool when read-only
+  disk_manager = new DiskManager("test.db", true, true, true);
+  EXPECT_FALSE(disk_manager->IsMapped());
+  BufferPoolManager *bpm = new BufferPoolManager(2, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    auto page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    if (i != 3 && i != 5 && i != 7) {
+      snprintf(expected, PAGE_SIZE, "page %d", i);
+      EXPECT_EQ(0, strcmp(expected, page->GetData()));
+    }
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  page_id_t temp_page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id));
+  delete bpm;
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+}
+
+// record headers with impossible sizes end the record walk instead of being
+// read into a page sized buffer
+TEST(DiskManagerTest, CorruptRecordHeaderTest) {
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+
+  DiskManager *disk_manager = new DiskManager("test.db", false, true, true);
+  for (int i = 0; i < 3; ++i) {
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_manager->WritePage(disk_manager->AllocatePage(), data);
+  }
+  delete disk_manager;
+
+  // capacity and length of the first record header, after its page id
+  uint16_t sizes[2];
+  std::fstream file("test.db", std::ios::binary | std::ios::in |
+                                   std::ios::out);
+  file.seekg(sizeof(page_id_t));
+  file.read(reinterpret_cast<char *>(sizes), sizeof(sizes));
+  const uint16_t good_capacity = sizes[0];
+  const uint16_t bad_sizes[2][2] = {{60000, 10}, {32, 40}};
+  for (auto &bad : bad_sizes) {
+    file.seekp(sizeof(page_id_t));
+    file.write(reinterpret_cast<const char *>(bad), sizeof(bad));
+    file.flush();
+    disk_manager = new DiskManager("test.db", false, true, true);
+    EXPECT_EQ(0, disk_manager->AllocatePage());
+    EXPECT_TRUE(disk_manager->ReadPage(0, buffer));
+    EXPECT_EQ(0, buffer[0]);
+    delete disk_manager;
+  }
+  // the intact file still loads
+  sizes[0] = good_capacity;
+  file.seekp(sizeof(page_id_t));
+  file.write(reinterpret_cast<char *>(sizes), sizeof(sizes));
+  file.close();
+  disk_manager = new DiskManager("test.db", false, true, true);
+  EXPECT_EQ(3, disk_manager->AllocatePage());
+  EXPECT_TRUE(disk_manager->ReadPage(2, buffer));
+  EXPECT_STREQ("page 2", buffer);
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test.log");
+}
+
+// a crash between writing the moved record of a page and retiring the old
+// one leaves two live records, the newer one is read back
+TEST(DiskManagerTest, TornMoveTest) {
+  // page id, capacity, length, crc, sequence number
+  const size_t header_size = 16;
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+
+  DiskManager *disk_manager = new DiskManager("test.db", false, true, true);
+  for (int i = 0; i < 4; ++i) {
+    memset(data, 0, PAGE_SIZE);
+    snprintf(data, PAGE_SIZE, "page %d", i);
+    disk_manager->WritePage(disk_manager->AllocatePage(), data);
+  }
+  srand(1);
+  for (int i = 0; i < PAGE_SIZE; ++i)
+    data[i] = static_cast<char>(rand());
+  disk_manager->WritePage(1, data);
+  delete disk_manager;
+
+  // revive the old record of page 1 behind the new one, as if the page had
+  // moved into a dead record ahead of it
+  std::fstream file("test.db", std::ios::binary | std::ios::in |
+                                   std::ios::out | std::ios::ate);
+  size_t file_size = file.tellg(), offset = 0;
+  std::string record;
+  while (offset + header_size <= file_size) {
+    page_id_t page_id;
+    uint16_t capacity;
+    file.seekg(offset);
+    file.read(reinterpret_cast<char *>(&page_id), sizeof(page_id));
+    file.read(reinterpret_cast<char *>(&capacity), sizeof(capacity));
+    if (page_id == INVALID_PAGE_ID) {
+      record.resize(header_size + capacity);
+      file.seekg(offset);
+      file.read(&record[0], record.size());
+      break;
+    }
+    offset += header_size + capacity;
+  }
+  ASSERT_FALSE(record.empty());
+  page_id_t page_id = 1;
+  memcpy(&record[0], &page_id, sizeof(page_id));
+  file.seekp(file_size);
+  file.write(record.data(), record.size());
+  file.close();
+
+  disk_manager = new DiskManager("test.db", false, true, true);
+  EXPECT_EQ(4, disk_manager->AllocatePage());
+  EXPECT_TRUE(disk_manager->ReadPage(1, buffer));
+  EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+  // the stale record is reused
+  memset(data, 0, PAGE_SIZE);
+  snprintf(data, PAGE_SIZE, "page %d", 4);
+  disk_manager->WritePage(4, data);
+  delete disk_manager;
+  std::ifstream check("test.db", std::ios::binary | std::ios::ate);
+  EXPECT_EQ(file_size + record.size(), static_cast<size_t>(check.tellg()));
+  check.close();
+
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(DiskManagerTest, TablespaceTest) {
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  EXPECT_EQ(0, disk_manager->AllocatePage());
+  int file_a = disk_manager->CreateFile();
+  int file_b = disk_manager->CreateFile();
+  EXPECT_EQ(1, file_a);
+  EXPECT_EQ(2, file_b);
+  EXPECT_EQ(0, access("test_1.db", F_OK));
+  EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage(3));
+
+  // page numbers restart in every file, the file id sits in the high bits
+  page_id_t page_a = disk_manager->AllocatePage(file_a);
+  page_id_t page_b = disk_manager->AllocatePage(file_b);
+  EXPECT_EQ(1 << FILE_ID_SHIFT, page_a);
+  EXPECT_EQ(file_b, DiskManager::GetFileId(page_b));
+  EXPECT_EQ(1, disk_manager->AllocatePage());
+  strcpy(data, "in file a");
+  disk_manager->WritePage(page_a, data);
+  strcpy(data, "in file b");
+  disk_manager->WritePage(page_b, data);
+  delete disk_manager;
+
+  // existing files are picked up again
+  disk_manager = new DiskManager("test.db");
+  EXPECT_TRUE(disk_manager->HasFile(file_a));
+  EXPECT_TRUE(disk_manager->HasFile(file_b));
+  EXPECT_TRUE(disk_manager->ReadPage(page_a, buffer));
+  EXPECT_EQ(0, strcmp(buffer, "in file a"));
+  EXPECT_TRUE(disk_manager->ReadPage(page_b, buffer));
+  EXPECT_EQ(0, strcmp(buffer, "in file b"));
+
+  // the buffer pool refuses to drop a file with pinned pages
+  BufferPoolManager *bpm = new BufferPoolManager(4, disk_manager);
+  page_id_t temp_page_id;
+  auto page = bpm->NewPage(temp_page_id, file_a);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(file_a, DiskManager::GetFileId(temp_page_id));
+  EXPECT_EQ(nullptr, bpm->NewPage(temp_page_id, 7));
+  EXPECT_FALSE(bpm->DropFile(file_a));
+  EXPECT_TRUE(bpm->UnpinPage(page->GetPageId(), true));
+  EXPECT_TRUE(bpm->DropFile(file_a));
+  EXPECT_FALSE(bpm->DropFile(0));
+  EXPECT_NE(0, access("test_1.db", F_OK));
+  EXPECT_FALSE(disk_manager->HasFile(file_a));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_b));
+  EXPECT_EQ(0, strcmp(bpm->FetchPage(page_b)->GetData(), "in file b"));
+  EXPECT_TRUE(bpm->UnpinPage(page_b, false));
+  EXPECT_TRUE(bpm->UnpinPage(page_b, false));
+  // a dropped file id is handed out again, empty
+  EXPECT_EQ(file_a, disk_manager->CreateFile());
+  EXPECT_TRUE(disk_manager->ReadPage(page_a, buffer));
+  EXPECT_EQ(0, buffer[0]);
+  delete bpm;
+  delete disk_manager;
+
+  remove("test.db");
+  remove("test_1.db");
+  remove("test_2.db");
+  remove("test.log");
+}
+
+// sparse file of several GB, offsets beyond 2^31 and 2^32
+TEST(DiskManagerTest, LargeFileTest) {
+  const page_id_t max_page_no = (1 << FILE_ID_SHIFT) - 1;
+  const page_id_t page_nos[] = {0, 3, 4200000, 6000000, max_page_no};
+  char data[PAGE_SIZE];
+  char buffer[PAGE_SIZE];
+
+  for (int checksum = 0; checksum < 2; ++checksum) {
+    DiskManager *disk_manager = new DiskManager("test.db", false, checksum);
+    for (page_id_t page_no : page_nos) {
+      memset(data, 0, PAGE_SIZE);
+      snprintf(data, PAGE_SIZE, "page %d", page_no);
+      data[PAGE_SIZE - 1] = 'z';
+      disk_manager->WritePage(page_no, data);
+    }
+    delete disk_manager;
+
+    struct stat stat_buf;
+    ASSERT_EQ(0, stat("test.db", &stat_buf));
+    size_t slot_size = checksum ? PAGE_SIZE + CHECKSUM_SIZE : PAGE_SIZE;
+    EXPECT_EQ((max_page_no + 1) * slot_size,
+              static_cast<size_t>(stat_buf.st_size));
+
+    // reopen: allocation continues after the last page, and the file is full
+    disk_manager = new DiskManager("test.db", false, checksum);
+    EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+    for (page_id_t page_no : page_nos) {
+      EXPECT_TRUE(disk_manager->ReadPage(page_no, buffer));
+      snprintf(data, PAGE_SIZE, "page %d", page_no);
+      EXPECT_EQ(0, strcmp(data, buffer)) << "page " << page_no;
+      EXPECT_EQ('z', buffer[PAGE_SIZE - 1]);
+    }
+    // holes read back as empty pages
+    EXPECT_TRUE(disk_manager->ReadPage(5000000, buffer));
+    EXPECT_EQ(0, buffer[0]);
+    EXPECT_EQ(0, disk_manager->GetNumChecksumFailures());
+    delete disk_manager;
+
+    // same pages through the read-only mapping
+    disk_manager = new DiskManager("test.db", true, checksum);
+    char *mapped = disk_manager->GetMappedPage(max_page_no);
+    ASSERT_NE(nullptr, mapped);
+    snprintf(data, PAGE_SIZE, "page %d", max_page_no);
+    EXPECT_EQ(0, strcmp(data, mapped));
+    // the next page id is page 0 of file 1, which does not exist
+    EXPECT_EQ(nullptr, disk_manager->GetMappedPage(max_page_no + 1));
+    delete disk_manager;
+
+    // drop the last page: max_page_no is now the first page past the end of
+    // file 0 and the page before it the last one in the file
+    ASSERT_EQ(0, truncate("test.db", max_page_no * slot_size));
+    disk_manager = new DiskManager("test.db", true, checksum);
+    EXPECT_NE(nullptr, disk_manager->GetMappedPage(max_page_no - 1));
+    EXPECT_EQ(nullptr, disk_manager->GetMappedPage(max_page_no));
+    EXPECT_TRUE(disk_manager->ReadPage(max_page_no, buffer));
+    EXPECT_EQ(0, buffer[0]);
+    delete disk_manager;
+    // the dropped page is the only one left to allocate in file 0
+    disk_manager = new DiskManager("test.db", false, checksum);
+    EXPECT_EQ(max_page_no, disk_manager->AllocatePage());
+    EXPECT_EQ(INVALID_PAGE_ID, disk_manager->AllocatePage());
+    delete disk_manager;
+
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+TEST(DiskManagerTest, ChecksumBenchmarkTest) {
+  const int num_pages = 2000;
+  const int rounds = 5;
+  char data[PAGE_SIZE];
+  for (int i = 0; i < PAGE_SIZE; ++i)
+    data[i] = static_cast<char>(i * 31);
+
+  // raw checksum throughput
+  auto start = std::chrono::steady_clock::now();
+  uint32_t crc = 0;
+  for (int i = 0; i < num_pages * rounds; ++i)
+    crc = Crc32c(data, PAGE_SIZE, crc);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "crc32c: "
+            << num_pages * rounds * (double)PAGE_SIZE / elapsed.count() / 1e6
+            << " MB/s (crc " << crc << ")" << std::endl;
+
+  for (int checksum = 0; checksum < 2; ++checksum) {
+    DiskManager *disk_manager = new DiskManager("test.db", false, checksum);
+    char buffer[PAGE_SIZE];
+    std::chrono::duration<double> write_time(0), read_time(0);
+    for (int r = 0; r < rounds; ++r) {
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < num_pages; ++i)
+        disk_manager->WritePage(i, data);
+      write_time += std::chrono::steady_clock::now() - start;
+      start = std::chrono::steady_clock::now();
+      for (int i = 0; i < num_pages; ++i)
+        EXPECT_TRUE(disk_manager->ReadPage(i, buffer));
+      read_time += std::chrono::steady_clock::now() - start;
+    }
+    EXPECT_EQ(0, memcmp(data, buffer, PAGE_SIZE));
+    std::cout << (checksum ? "with checksum:    " : "without checksum: ")
+              << "write " << num_pages * rounds / write_time.count()
+              << " pages/s, read " << num_pages * rounds / read_time.count()
+              << " pages/s" << std::endl;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+} // namespace scudb
@@ -3,6 +3,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <cstdio>
 #include <functional>
@@ -69,6 +70,24 @@ void InsertHelperSplit(
   delete transaction;
 }
 
+// helper function to append keys handed out by a shared counter, the way an
+// autoincrement column does
+void AppendHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+                  std::atomic<int64_t> &next_key, int64_t last_key,
+                  __attribute__((unused)) uint64_t thread_itr) {
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  for (int64_t key = next_key++; key <= last_key; key = next_key++) {
+    int64_t value = key & 0xFFFFFFFF;
+    rid.Set((int32_t)(key >> 32), value);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  delete transaction;
+}
+
 // helper function to delete
 void DeleteHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
                   const std::vector<int64_t> &remove_keys,
@@ -100,6 +119,41 @@ void DeleteHelperSplit(
   delete transaction;
 }
 
+// helper function to look up keys that must stay in the tree
+void LookupHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+                  const std::vector<int64_t> &keys,
+                  __attribute__((unused)) uint64_t thread_itr = 0) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    EXPECT_EQ(rids.size(), 1);
+  }
+}
+
+// look up keys in batches, every key is expected to be found
+void BatchLookupHelper(
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> &tree,
+    const std::vector<int64_t> &keys,
+    __attribute__((unused)) uint64_t thread_itr = 0) {
+  const size_t batch_size = 64;
+  GenericKey<8> index_key;
+  std::vector<GenericKey<8>> batch;
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i += batch_size) {
+    batch.clear();
+    rids.clear();
+    for (size_t j = i; j < std::min(i + batch_size, keys.size()); j++) {
+      index_key.SetFromInteger(keys[j]);
+      batch.push_back(index_key);
+    }
+    EXPECT_EQ(tree.GetValues(batch, rids), (int)batch.size());
+    EXPECT_EQ(rids.size(), batch.size());
+  }
+}
+
 TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
@@ -301,6 +355,58 @@ TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, CompactionThreadTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 3000; key++)
+    keys.push_back(key);
+  InsertHelper(tree, keys);
+
+  // compact as often as there is something to do, next to the deletes
+  auto timeout = COMPACTION_TIMEOUT;
+  COMPACTION_TIMEOUT = std::chrono::seconds(0);
+  tree.RunCompactionThread();
+  std::vector<int64_t> remove_keys;
+  for (auto key : keys)
+    if (key % 7 != 0)
+      remove_keys.push_back(key);
+  LaunchParallelTest(2, DeleteHelperSplit, std::ref(tree), remove_keys, 2);
+  tree.StopCompactionThread();
+  COMPACTION_TIMEOUT = timeout;
+  tree.Compact();
+
+  int64_t current_key = 7;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key += 7;
+  }
+  EXPECT_EQ(current_key, 3003);
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    EXPECT_EQ(rids.size(), key % 7 == 0 ? 1 : 0);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   Schema *key_schema = ParseCreateStatement("a bigint");
@@ -348,4 +454,248 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, ScaleMixTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // populate with many threads
+  const int num_threads = 16;
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 5000; key++)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  LaunchParallelTest(num_threads, InsertHelperSplit, std::ref(tree), keys,
+                     num_threads);
+
+  // delete the odd keys while the even keys are looked up
+  std::vector<int64_t> odd_keys, even_keys;
+  for (auto key : keys)
+    (key % 2 ? odd_keys : even_keys).push_back(key);
+  std::vector<std::thread> thread_group;
+  for (int i = 0; i < num_threads; i++) {
+    thread_group.push_back(std::thread(DeleteHelperSplit, std::ref(tree),
+                                       odd_keys, num_threads, i));
+    thread_group.push_back(
+        std::thread(LookupHelper, std::ref(tree), even_keys, i));
+    thread_group.push_back(
+        std::thread(BatchLookupHelper, std::ref(tree), even_keys, i));
+  }
+  for (auto &thread : thread_group)
+    thread.join();
+
+  int64_t current_key = 2;
+  index_key.SetFromInteger(current_key);
+  for (auto iterator = tree.Begin(index_key); iterator.isEnd() == false;
+       ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 2;
+  }
+  EXPECT_EQ(current_key, 5002);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, LookupUnderInsertTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+  // even keys are present from the start, odd keys split pages under readers
+  const int num_threads = 8;
+  std::vector<int64_t> odd_keys, even_keys;
+  for (int64_t key = 1; key <= 10000; key++)
+    (key % 2 ? odd_keys : even_keys).push_back(key);
+  std::random_shuffle(odd_keys.begin(), odd_keys.end());
+  InsertHelper(tree, even_keys);
+
+  std::vector<std::thread> writers, readers;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_threads; i++) {
+    writers.push_back(std::thread(InsertHelperSplit, std::ref(tree),
+                                  odd_keys, num_threads, i));
+    readers.push_back(
+        std::thread(LookupHelper, std::ref(tree), even_keys, i));
+  }
+  for (auto &thread : readers)
+    thread.join();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  for (auto &thread : writers)
+    thread.join();
+  std::cout << "lookup latency under inserts: "
+            << elapsed.count() * 1e6 / even_keys.size() << " us" << std::endl;
+
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator)
+    size = size + 1;
+  EXPECT_EQ(size, 10000);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// filter rebuilds walk the tree while other threads insert: no key added
+// meanwhile may go missing from the new filter
+TEST(BPlusTreeConcurrentTest, FilterRebuildTest) {
+  Schema *schema = ParseCreateStatement("a bigint");
+  std::string sql = "bloom foo_a a";
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  Index *index = ConstructIndex(ParseIndexStatement(sql, "foo", schema), bpm,
+                                INVALID_PAGE_ID);
+
+  const int num_threads = 4;
+  const int64_t num_keys = 20000;
+  auto insert = [&](int thread_itr) {
+    Transaction transaction(0);
+    RID rid;
+    for (int64_t key = thread_itr; key < num_keys; key += num_threads) {
+      rid.Set(0, key);
+      index->InsertEntry(Tuple({Value(TypeId::BIGINT, key)},
+                               index->GetEntrySchema()),
+                         rid, &transaction);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++)
+    threads.push_back(std::thread(insert, i));
+  for (auto &thread : threads)
+    thread.join();
+
+  Transaction transaction(0);
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < num_keys; key++)
+    index->ScanKey(Tuple({Value(TypeId::BIGINT, key)}, index->GetKeySchema()),
+                   rids, &transaction);
+  EXPECT_EQ(rids.size(), num_keys);
+  EXPECT_EQ(index->GetFilterStats().negatives, 0);
+
+  delete index;
+  delete schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, InsertScalingBenchmark) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 20000; key++)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+
+  for (int num_threads = 1; num_threads <= 16; num_threads *= 2) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                             comparator);
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void)header_page;
+
+    auto start = std::chrono::steady_clock::now();
+    LaunchParallelTest(num_threads, InsertHelperSplit, std::ref(tree), keys,
+                       num_threads);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << num_threads << " threads: "
+              << keys.size() / elapsed.count() << " inserts/s" << std::endl;
+
+    int64_t size = 0;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator)
+      size = size + 1;
+    EXPECT_EQ(size, (int64_t)keys.size());
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+// monotonic keys, every insert lands in the right-most leaf
+TEST(BPlusTreeConcurrentTest, AppendScalingBenchmark) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 20000; key++)
+    keys.push_back(key);
+
+  for (int num_threads = 1; num_threads <= 16; num_threads *= 2) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                             comparator);
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(page_id);
+    (void)header_page;
+
+    std::atomic<int64_t> next_key(1);
+    auto start = std::chrono::steady_clock::now();
+    LaunchParallelTest(num_threads, AppendHelper, std::ref(tree),
+                       std::ref(next_key), keys.back());
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    // appenders take turns on the right-most leaf latch, the rate does not
+    // grow with threads. Printed only, wall clock time is not checked
+    std::cout << num_threads << " threads: "
+              << keys.size() / elapsed.count() << " appends/s" << std::endl;
+
+    // deletes merge the right edge away, appends go on after them
+    std::vector<int64_t> remove_keys(keys.end() - 5000, keys.end());
+    DeleteHelper(tree, remove_keys);
+    next_key = 20001;
+    LaunchParallelTest(num_threads, AppendHelper, std::ref(tree),
+                       std::ref(next_key), 21000);
+
+    int64_t current_key = 1;
+    for (auto iterator = tree.Begin(); iterator.isEnd() == false;
+         ++iterator) {
+      if (current_key == 15001)
+        current_key = 20001;
+      EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+      current_key = current_key + 1;
+    }
+    EXPECT_EQ(current_key, 21001);
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+  delete key_schema;
+}
+
 } // namespace scudb
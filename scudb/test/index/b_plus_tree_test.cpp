@@ -3,6 +3,7 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <iostream>
 #include <sstream>
@@ -10,6 +11,7 @@
 #include "buffer/buffer_pool_manager.h"
 #include "common/logger.h"
 #include "index/b_plus_tree.h"
+#include "page/header_page.h"
 #include "vtable/virtual_table.h"
 #include "gtest/gtest.h"
 
@@ -390,4 +392,739 @@ TEST(BPlusTreeTests, ScaleTest) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // load even keys, leaving room in every page for the odd ones
+  int64_t scale = 10000;
+  std::vector<std::pair<GenericKey<8>, RID>> items;
+  for (int64_t key = 2; key < scale; key += 2) {
+    index_key.SetFromInteger(key);
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    items.emplace_back(index_key, rid);
+  }
+  EXPECT_TRUE(tree.BulkLoad(items, 0.7));
+  // only an empty tree can be loaded
+  EXPECT_FALSE(tree.BulkLoad(items));
+
+  std::vector<RID> rids;
+  for (int64_t key = 2; key < scale; key += 2) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+    EXPECT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  // the loaded tree takes regular inserts and removes
+  for (int64_t key = 1; key < scale; key += 2) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  for (int64_t key = 1; key < scale / 2; key++) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+
+  int64_t current_key = scale / 2;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, scale);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// number followed by a tail of varying length, so keys order by number
+VarlenKey StringKey(Schema *key_schema, int64_t key) {
+  char number[8];
+  snprintf(number, sizeof(number), "%06d", (int)key);
+  std::vector<Value> values;
+  values.emplace_back(TypeId::VARCHAR,
+                      std::string(number) + std::string(key % 30, 'x'));
+  VarlenKey index_key;
+  index_key.SetFromKey(Tuple(values, key_schema), key_schema);
+  return index_key;
+}
+
+TEST(BPlusTreeTests, VarlenKeyTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a varchar(40)");
+  VarlenComparator comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  // create b+ tree
+  BPlusTree<VarlenKey, RID, VarlenComparator> tree("foo_pk", bpm, comparator);
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  // load even keys, insert odd ones in random order
+  int64_t scale = 3000;
+  std::vector<std::pair<VarlenKey, RID>> items;
+  for (int64_t key = 0; key < scale; key += 2) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    items.emplace_back(StringKey(key_schema, key), rid);
+  }
+  EXPECT_TRUE(tree.BulkLoad(items, 0.7));
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key < scale; key += 2)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    EXPECT_TRUE(tree.Insert(StringKey(key_schema, key), rid, transaction));
+  }
+  EXPECT_FALSE(tree.Insert(StringKey(key_schema, 1), rid, transaction));
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    tree.GetValue(StringKey(key_schema, key), rids);
+    EXPECT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+
+  // remove every key but the multiples of 3, in random order
+  keys.clear();
+  for (int64_t key = 0; key < scale; key++)
+    if (key % 3 != 0)
+      keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  for (auto key : keys)
+    tree.Remove(StringKey(key_schema, key), transaction);
+
+  int64_t current_key = 0;
+  for (auto iterator = tree.Begin(StringKey(key_schema, 0));
+       iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key = current_key + 3;
+  }
+  EXPECT_EQ(current_key, scale);
+
+  for (int64_t key = 0; key < scale; key += 3)
+    tree.Remove(StringKey(key_schema, key), transaction);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, SeparatorTest) {
+  VarlenKey left, right;
+  left.SetFromBytes("abcx", 4);
+  right.SetFromBytes("abdy", 4);
+  EXPECT_EQ(std::string(ShortestSeparator(left, right).data, 3), "abd");
+  EXPECT_EQ(ShortestSeparator(left, right).GetSize(), 3);
+  // a key sorts before its extensions
+  left.SetFromBytes("ab", 2);
+  EXPECT_EQ(ShortestSeparator(left, right).GetSize(), 3);
+  left.SetFromBytes("abd", 3);
+  EXPECT_EQ(ShortestSeparator(left, right).GetSize(), 4);
+
+  // keys share no tail, so separators keep about the 6 digits
+  Schema *key_schema = ParseCreateStatement("a varchar(50)");
+  VarlenComparator comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<VarlenKey, RID, VarlenComparator> tree("foo_pk", bpm, comparator);
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 2000;
+  std::vector<int64_t> keys;
+  for (int64_t key = 0; key < scale; key++)
+    keys.push_back(key);
+  std::random_shuffle(keys.begin(), keys.end());
+  auto long_key = [&](int64_t key) {
+    char number[8];
+    snprintf(number, sizeof(number), "%06d", (int)key);
+    std::vector<Value> values;
+    values.emplace_back(TypeId::VARCHAR,
+                        std::string(number) + std::string(40, 'x'));
+    VarlenKey index_key;
+    index_key.SetFromKey(Tuple(values, key_schema), key_schema);
+    return index_key;
+  };
+  for (auto key : keys) {
+    rid.Set(0, key);
+    EXPECT_TRUE(tree.Insert(long_key(key), rid, transaction));
+  }
+
+  // the level above the leaves fans out further than whole keys could
+  auto levels = tree.GetLevelStats();
+  ASSERT_GE(levels.size(), 2);
+  auto &parents = levels[levels.size() - 2];
+  int item_size = BPlusTreeVarlenPage<page_id_t>::ItemSize(
+      std::make_pair(long_key(0), INVALID_PAGE_ID));
+  EXPECT_GT(parents.entries / parents.pages, PAGE_SIZE / item_size);
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < scale; key++) {
+    rids.clear();
+    tree.GetValue(long_key(key), rids);
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  for (auto key : keys)
+    tree.Remove(long_key(key), transaction);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  delete key_schema;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, KeyToValueTest) {
+  Schema *key_schema = ParseCreateStatement("a smallint, b varchar(16), c "
+                                            "double, d bigint");
+  std::string text("x\0y", 3);
+  std::vector<Value> values = {
+      Value(TypeId::SMALLINT, static_cast<int16_t>(-3)),
+      Value(TypeId::VARCHAR, text), Value(TypeId::DECIMAL, -0.25),
+      Value(TypeId::BIGINT, static_cast<int64_t>(1) << 40)};
+  Tuple tuple(values, key_schema);
+
+  GenericKey<32> generic_key;
+  generic_key.SetFromKey(tuple, key_schema);
+  VarlenKey varlen_key;
+  varlen_key.SetFromKey(tuple, key_schema);
+  for (int i = 0; i < key_schema->GetColumnCount(); i++) {
+    EXPECT_EQ(generic_key.ToValue(key_schema, i).CompareEquals(values[i]),
+              CMP_TRUE);
+    EXPECT_EQ(varlen_key.ToValue(key_schema, i).CompareEquals(values[i]),
+              CMP_TRUE);
+  }
+  EXPECT_EQ(generic_key.ToValue(key_schema, 1).GetLength(), 4);
+
+  Schema *integer_schema = ParseCreateStatement("a int");
+  Tuple integer_tuple({Value(TypeId::INTEGER, -7)}, integer_schema);
+  IntegerKey<4> integer_key;
+  integer_key.SetFromKey(integer_tuple, integer_schema);
+  EXPECT_EQ(integer_key.ToValue(integer_schema, 0).GetAs<int32_t>(), -7);
+
+  delete key_schema;
+  delete integer_schema;
+}
+
+TEST(BPlusTreeTests, GetValuesTest) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(30, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create transaction
+  Transaction *transaction = new Transaction(0);
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  std::vector<GenericKey<8>> probes;
+  std::vector<RID> rids;
+  EXPECT_EQ(tree.GetValues(probes, rids), 0);
+  // multiples of 3 are in the tree
+  for (int64_t key = 3; key < 3000; key += 3) {
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  // probe every key twice, in reverse order
+  for (int64_t key = 3100; key > 0; key--) {
+    index_key.SetFromInteger(key);
+    probes.push_back(index_key);
+    probes.push_back(index_key);
+  }
+  EXPECT_EQ(tree.GetValues(probes, rids), 999);
+  EXPECT_EQ(rids.size(), 999);
+  for (size_t i = 0; i < rids.size(); i++)
+    EXPECT_EQ(rids[i].GetSlotNum(), 3 * (int64_t)(i + 1));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, LevelStatsTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  EXPECT_TRUE(tree.GetLevelStats().empty());
+  int64_t scale = 2000;
+  for (int64_t key = 1; key <= scale; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+
+  auto levels = tree.GetLevelStats();
+  ASSERT_GE(levels.size(), 2);
+  EXPECT_EQ(levels.front().pages, 1);
+  EXPECT_EQ(levels.back().entries, scale);
+  // every entry of an internal page is a page of the level below
+  for (size_t i = 0; i + 1 < levels.size(); i++)
+    EXPECT_EQ(levels[i].entries, levels[i + 1].pages);
+  for (auto &level : levels) {
+    EXPECT_GT(level.fill_factor, 0);
+    EXPECT_LE(level.fill_factor, 1);
+  }
+  // ascending inserts split off just the new key and leave full leaves
+  EXPECT_GT(levels.back().fill_factor, 0.9);
+
+  // random descents see the same height and about as many entries
+  std::vector<GenericKey<8>> leaf_keys;
+  auto sampled = tree.SampleLevelStats(8, leaf_keys);
+  ASSERT_EQ(sampled.size(), levels.size());
+  EXPECT_EQ(leaf_keys.size(), 8);
+  EXPECT_EQ(sampled.front().pages, 1);
+  EXPECT_EQ(sampled.front().entries, levels.front().entries);
+  EXPECT_GT(sampled.back().entries, scale / 2);
+  EXPECT_LT(sampled.back().entries, scale * 2);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, CompactTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 2000;
+  for (int64_t key = 1; key <= scale; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+  }
+  int leaves = tree.GetLevelStats().back().pages;
+
+  // deletes leave every leaf underfull but none empty
+  for (int64_t key = 1; key <= scale; key++) {
+    if (key % 10 == 0)
+      continue;
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_EQ(tree.GetLevelStats().back().pages, leaves);
+
+  EXPECT_GT(tree.Compact(transaction), 0);
+  auto levels = tree.GetLevelStats();
+  EXPECT_LT(levels.back().pages, leaves / 4);
+  EXPECT_EQ(levels.back().entries, scale / 10);
+  // nothing is left to do
+  EXPECT_EQ(tree.Compact(transaction), 0);
+
+  int64_t current_key = 10;
+  for (auto iterator = tree.Begin(); iterator.isEnd() == false; ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key);
+    current_key += 10;
+  }
+  EXPECT_EQ(current_key, scale + 10);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, RootCatalogTest) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  RootCatalog *catalog = new RootCatalog(bpm);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+      "foo_pk", bpm, comparator, INVALID_PAGE_ID, catalog);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> other_tree(
+      "bar_pk", bpm, comparator, INVALID_PAGE_ID, catalog);
+  GenericKey<8> index_key;
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  for (int64_t key = 1; key <= 1000; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid, transaction);
+    if (key <= 10)
+      other_tree.Insert(index_key, rid, transaction);
+  }
+  for (int64_t key = 1; key <= 10; key++) {
+    index_key.SetFromInteger(key);
+    other_tree.Remove(index_key, transaction);
+  }
+
+  // roots written through reach the header page
+  HeaderPage *header_page =
+      static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  page_id_t root_id, cached_root_id;
+  EXPECT_TRUE(header_page->GetRootId("foo_pk", root_id));
+  EXPECT_TRUE(catalog->GetRootId("foo_pk", cached_root_id));
+  EXPECT_EQ(root_id, cached_root_id);
+  EXPECT_TRUE(header_page->GetRootId("bar_pk", root_id));
+  EXPECT_EQ(root_id, INVALID_PAGE_ID);
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+
+  // a new catalog loads them back
+  RootCatalog reloaded(bpm);
+  EXPECT_TRUE(reloaded.GetRootId("foo_pk", root_id));
+  EXPECT_EQ(root_id, cached_root_id);
+  EXPECT_TRUE(reloaded.DeleteRecord("bar_pk"));
+  EXPECT_FALSE(reloaded.GetRootId("bar_pk", root_id));
+  EXPECT_FALSE(reloaded.DeleteRecord("bar_pk"));
+  EXPECT_TRUE(reloaded.SetRootId("bar_pk", 5));
+  EXPECT_TRUE(reloaded.SetRootId("bar_pk", 6));
+  EXPECT_TRUE(reloaded.GetRootId("bar_pk", root_id));
+  EXPECT_EQ(root_id, 6);
+  // a full header page takes no more records, updates still go through
+  int records = 2;
+  EXPECT_TRUE(reloaded.HasRoom(HeaderPage::MAX_RECORD_COUNT - records));
+  EXPECT_FALSE(reloaded.HasRoom(HeaderPage::MAX_RECORD_COUNT - records + 1));
+  for (; records < HeaderPage::MAX_RECORD_COUNT; records++)
+    EXPECT_TRUE(reloaded.SetRootId("t" + std::to_string(records), 7));
+  EXPECT_FALSE(reloaded.HasRoom(1));
+  EXPECT_FALSE(reloaded.SetRootId("full", 7));
+  EXPECT_FALSE(reloaded.GetRootId("full", root_id));
+  EXPECT_TRUE(reloaded.SetRootId("bar_pk", 8));
+  EXPECT_FALSE(reloaded.SetRootId(std::string(32, 'a'), 7));
+
+  delete transaction;
+  delete catalog;
+  delete key_schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, FilterTest) {
+  Schema *schema = ParseCreateStatement("a bigint, b varchar(8)");
+  std::string sql = "bloom foo_a a";
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(page_id);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  Index *index = ConstructIndex(ParseIndexStatement(sql, "foo", schema), bpm,
+                                INVALID_PAGE_ID);
+  RID rid;
+  Transaction *transaction = new Transaction(0);
+
+  // even keys only, more than the filter is first sized for
+  for (int64_t key = 0; key < 4000; key += 2) {
+    rid.Set(0, key);
+    index->InsertEntry(Tuple({Value(TypeId::BIGINT, key)},
+                             index->GetEntrySchema()),
+                       rid, transaction);
+  }
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < 4000; key++) {
+    rids.clear();
+    index->ScanKey(Tuple({Value(TypeId::BIGINT, key)}, index->GetKeySchema()),
+                   rids, transaction);
+    EXPECT_EQ(rids.size(), key % 2 == 0 ? 1 : 0);
+  }
+  FilterStats stats = index->GetFilterStats();
+  // a key the filter takes for one it holds is not added again
+  EXPECT_LE(stats.keys, 2000);
+  EXPECT_GT(stats.keys, 1900);
+  EXPECT_EQ(stats.lookups, 4000);
+  EXPECT_EQ(stats.negatives + stats.false_positives, 2000);
+  EXPECT_LT(stats.GetFalsePositiveRate(), 0.05);
+
+  // an index opened on the tree builds its filter from the keys
+  HeaderPage *header_page =
+      static_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+  page_id_t root_id;
+  EXPECT_TRUE(header_page->GetRootId("foo_a", root_id));
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  sql = "bloom foo_a a";
+  Index *reopened =
+      ConstructIndex(ParseIndexStatement(sql, "foo", schema), bpm, root_id);
+  EXPECT_EQ(reopened->GetFilterStats().keys, 2000);
+  std::vector<Tuple> keys;
+  for (int64_t key = 0; key < 4000; key++)
+    keys.push_back(Tuple({Value(TypeId::BIGINT, key)},
+                         reopened->GetKeySchema()));
+  rids.clear();
+  reopened->ScanKeys(keys, rids, transaction);
+  EXPECT_EQ(rids.size(), 2000);
+  // range scans over a single key are point lookups too
+  int found = 0;
+  for (auto &key : keys)
+    for (auto scan = reopened->ScanRange(&key, true, &key, true);
+         !scan->IsEnd(); scan->Next())
+      found++;
+  EXPECT_EQ(found, 2000);
+  stats = reopened->GetFilterStats();
+  EXPECT_EQ(stats.lookups, 4000);
+  EXPECT_EQ(stats.negatives + stats.false_positives, 2000);
+  EXPECT_GT(stats.negatives, 1900);
+
+  // the key check of a unique index with included columns is not a lookup
+  sql = "unique bloom foo_b a include (b)";
+  Index *unique =
+      ConstructIndex(ParseIndexStatement(sql, "foo", schema), bpm,
+                     INVALID_PAGE_ID);
+  for (int64_t key = 0; key < 200; key++) {
+    rid.Set(1, key);
+    unique->InsertEntry(Tuple({Value(TypeId::BIGINT, key % 100),
+                               Value(TypeId::VARCHAR, "x")},
+                              unique->GetEntrySchema()),
+                        rid, transaction);
+  }
+  EXPECT_EQ(unique->GetFilterStats().lookups, 0);
+  rids.clear();
+  unique->ScanKey(Tuple({Value(TypeId::BIGINT, 7)}, unique->GetKeySchema()),
+                  rids, transaction);
+  ASSERT_EQ(rids.size(), 1);
+  EXPECT_EQ(rids[0].GetSlotNum(), 7);
+  delete unique;
+
+  delete reopened;
+  delete index;
+  delete transaction;
+  delete schema;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeTests, GetValuesBenchmark) {
+  // create KeyComparator and index schema
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema);
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(50, disk_manager);
+  // create b+ tree
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm,
+                                                           comparator);
+  GenericKey<8> index_key;
+  RID rid;
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  int64_t scale = 100000;
+  std::vector<std::pair<GenericKey<8>, RID>> items;
+  for (int64_t key = 1; key <= scale; key++) {
+    index_key.SetFromInteger(key);
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    items.emplace_back(index_key, rid);
+  }
+  tree.BulkLoad(items);
+
+  // 10k probes, dense (every key of a range) and sparse (spread out)
+  for (int64_t stride : {1, 10}) {
+    std::vector<GenericKey<8>> probes;
+    for (int64_t key = 1; key <= 10000; key++) {
+      index_key.SetFromInteger(key * stride);
+      probes.push_back(index_key);
+    }
+    std::random_shuffle(probes.begin(), probes.end());
+
+    std::vector<RID> rids;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &key : probes)
+      tree.GetValue(key, rids);
+    std::chrono::duration<double> single =
+        std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(rids.size(), probes.size());
+
+    rids.clear();
+    start = std::chrono::steady_clock::now();
+    EXPECT_EQ(tree.GetValues(probes, rids), (int)probes.size());
+    std::chrono::duration<double> batched =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "stride " << stride << ": " << single.count() * 1000
+              << " ms one by one, " << batched.count() * 1000
+              << " ms batched" << std::endl;
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// point lookups per second on a bulk loaded tree of scale keys. The buffer
+// pool holds every page of the tree, the rate is that of the key compares
+// rather than of the disk
+template <typename KeyType, typename KeyComparator>
+double LookupRate(Schema *key_schema, int64_t scale) {
+  KeyComparator comparator(key_schema);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManager(scale / 8 + 64, disk_manager);
+  BPlusTree<KeyType, RID, KeyComparator> tree("foo_pk", bpm, comparator);
+  KeyType index_key;
+  RID rid;
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(page_id);
+  (void)header_page;
+
+  std::vector<std::pair<KeyType, RID>> items;
+  for (int64_t key = 1; key <= scale; key++) {
+    index_key.SetFromInteger(key);
+    rid.Set((int32_t)(key >> 32), key & 0xFFFFFFFF);
+    items.emplace_back(index_key, rid);
+  }
+  tree.BulkLoad(items);
+  std::vector<int64_t> probes;
+  for (int64_t key = 1; key <= scale; key++)
+    probes.push_back(key);
+  std::random_shuffle(probes.begin(), probes.end());
+
+  std::vector<RID> rids;
+  auto start = std::chrono::steady_clock::now();
+  for (auto key : probes) {
+    index_key.SetFromInteger(key);
+    tree.GetValue(index_key, rids);
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  EXPECT_EQ(rids.size(), probes.size());
+  for (size_t i = 0; i < rids.size(); i++)
+    EXPECT_EQ(rids[i].GetSlotNum(), probes[i]);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+  return probes.size() / elapsed.count();
+}
+
+// binary searches per second in a full leaf page, where the key compares are
+// most of the work
+template <typename KeyType, typename KeyComparator>
+double SearchRate(Schema *key_schema, int64_t searches) {
+  KeyComparator comparator(key_schema);
+  char data[PAGE_SIZE];
+  auto *leaf =
+      reinterpret_cast<BPlusTreeLeafPage<KeyType, RID, KeyComparator> *>(data);
+  leaf->Init(1, INVALID_PAGE_ID);
+  KeyType index_key;
+  RID rid;
+  for (int key = 0; key < leaf->GetMaxSize(); key++) {
+    index_key.SetFromInteger(key * 2);
+    rid.Set(0, key);
+    leaf->Insert(index_key, rid, comparator);
+  }
+
+  // every key of the page and every gap between them
+  std::vector<KeyType> probes(leaf->GetSize() * 2);
+  for (size_t i = 0; i < probes.size(); i++)
+    probes[i].SetFromInteger(i * 7 % probes.size());
+  int64_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int64_t i = 0; i < searches; i++)
+    found += leaf->KeyIndex(probes[i % probes.size()], comparator);
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  EXPECT_GT(found, 0);
+  return searches / elapsed.count();
+}
+
+TEST(BPlusTreeTests, IntegerKeyBenchmark) {
+  Schema *key_schema = ParseCreateStatement("a bigint");
+  int64_t scale = 100000;
+  double generic =
+      LookupRate<GenericKey<8>, GenericComparator<8>>(key_schema, scale);
+  double integer =
+      LookupRate<IntegerKey<8>, IntegerComparator<8>>(key_schema, scale);
+  std::cout << "bigint key: " << generic << " lookups/s generic, " << integer
+            << " lookups/s integer" << std::endl;
+  // a tree lookup spends most of its time fetching and latching pages, the
+  // compares are told apart by the search within a page
+  generic = SearchRate<GenericKey<8>, GenericComparator<8>>(key_schema,
+                                                            scale * 20);
+  integer = SearchRate<IntegerKey<8>, IntegerComparator<8>>(key_schema,
+                                                            scale * 20);
+  std::cout << "bigint key: " << generic << " searches/s generic, " << integer
+            << " searches/s integer" << std::endl;
+  delete key_schema;
+}
 } // namespace scudb
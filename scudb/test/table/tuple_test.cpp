@@ -3,9 +3,11 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <iostream>
 #include <string>
+#include <sys/stat.h>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -61,4 +63,206 @@ TEST(TupleTest, TableHeapTest) {
   delete disk_manager;
 }
 
+// compression ratio and scan throughput of heap pages holding the tuples above
+TEST(TupleTest, CompressedStorageBenchmark) {
+  std::string createStmt =
+      "a varchar, b smallint, c bigint, d bool, e varchar(16)";
+  Schema *schema = ParseCreateStatement(createStmt);
+  // distinct tuples with the value ranges of ConstructTuple
+  static const char alphanum[] = "0123456789"
+                                 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                 "abcdefghijklmnopqrstuvwxyz";
+  srand(42);
+  std::vector<Tuple> tuples;
+  for (int i = 0; i < 2000; ++i) {
+    char s[2][10];
+    for (int j = 0; j < 2; ++j) {
+      int len = 1 + rand() % 9;
+      for (int k = 0; k < len; ++k)
+        s[j][k] = alphanum[rand() % (sizeof(alphanum) - 1)];
+      s[j][len] = 0;
+    }
+    std::vector<Value> values;
+    values.emplace_back(TypeId::VARCHAR, s[0], strlen(s[0]) + 1, true);
+    values.emplace_back(TypeId::SMALLINT, (int32_t)rand() % 1000);
+    values.emplace_back(TypeId::BIGINT, (int64_t)rand() % 100000);
+    values.emplace_back(TypeId::BOOLEAN, rand() % 2);
+    values.emplace_back(TypeId::VARCHAR, s[1], strlen(s[1]) + 1, true);
+    tuples.emplace_back(values, schema);
+  }
+
+  for (int compressed = 0; compressed < 2; ++compressed) {
+    Transaction *transaction = new Transaction(0);
+    DiskManager *disk_manager =
+        new DiskManager("test.db", false, false, compressed);
+    BufferPoolManager *buffer_pool_manager =
+        new BufferPoolManager(50, disk_manager);
+    LockManager *lock_manager = new LockManager(true);
+    LogManager *log_manager = new LogManager(disk_manager);
+    TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
+                                     log_manager, transaction);
+    RID rid;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &tuple : tuples)
+      table->InsertTuple(tuple, rid, transaction);
+    buffer_pool_manager->FlushAllPages();
+    std::chrono::duration<double> write_time =
+        std::chrono::steady_clock::now() - start;
+    page_id_t first_page_id = table->GetFirstPageId();
+    int num_pages = disk_manager->AllocatePage();
+    delete table;
+    delete buffer_pool_manager;
+
+    // scan through a small pool so every page comes from disk
+    buffer_pool_manager = new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager);
+    table = new TableHeap(buffer_pool_manager, lock_manager, log_manager,
+                          first_page_id);
+    int count = 0;
+    start = std::chrono::steady_clock::now();
+    for (auto itr = table->begin(transaction); itr != table->end(); ++itr)
+      count++;
+    std::chrono::duration<double> scan_time =
+        std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(2000, count);
+
+    struct stat stat_buf;
+    stat("test.db", &stat_buf);
+    double ratio = (double)num_pages * PAGE_SIZE / stat_buf.st_size;
+    std::cout << (compressed ? "compressed:   " : "uncompressed: ") << num_pages
+              << " pages, " << stat_buf.st_size << " bytes on disk (ratio "
+              << ratio << "), insert+flush " << write_time.count() * 1000
+              << " ms, scan " << num_pages / scan_time.count() << " pages/s"
+              << std::endl;
+    if (compressed) {
+      EXPECT_LT(1.0, ratio);
+    }
+
+    delete table;
+    delete buffer_pool_manager;
+    delete log_manager;
+    delete lock_manager;
+    delete disk_manager;
+    delete transaction;
+    remove("test.db");
+    remove("test.log");
+  }
+  delete schema;
+}
+
+// insert rate as the heap grows, the free space map keeps it flat where
+// walking the page chain made every insert cost O(pages)
+TEST(TupleTest, InsertScalingBenchmark) {
+  std::string createStmt =
+      "a varchar, b smallint, c bigint, d bool, e varchar(16)";
+  Schema *schema = ParseCreateStatement(createStmt);
+  Tuple tuple = ConstructTuple(schema);
+
+  Transaction *transaction = new Transaction(0);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
+                                   log_manager, transaction);
+
+  RID rid;
+  std::vector<RID> rids;
+  const int batch = 5000;
+  for (int round = 0; round < 4; ++round) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < batch; ++i) {
+      EXPECT_TRUE(table->InsertTuple(tuple, rid, transaction));
+      rids.push_back(rid);
+    }
+    std::chrono::duration<double> time =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "rows " << rids.size() - batch << "-" << rids.size() << ": "
+              << batch / time.count() << " inserts/s" << std::endl;
+  }
+
+  // the room deleted tuples leave is taken again before the heap grows
+  page_id_t first_page_id = table->GetFirstPageId();
+  page_id_t free_space_page_id = table->GetFreeSpacePageId();
+  int num_pages = disk_manager->AllocatePage();
+  for (int i = 0; i < batch; ++i) {
+    table->MarkDelete(rids[i], transaction);
+    table->ApplyDelete(rids[i], transaction);
+  }
+  delete table;
+  table = new TableHeap(buffer_pool_manager, lock_manager, log_manager,
+                        first_page_id);
+  EXPECT_EQ(free_space_page_id, table->GetFreeSpacePageId());
+  for (int i = 0; i < batch; ++i)
+    EXPECT_TRUE(table->InsertTuple(tuple, rid, transaction));
+  EXPECT_EQ(num_pages + 1, disk_manager->AllocatePage());
+
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+  delete schema;
+  remove("test.db");
+  remove("test.log");
+}
+
+// a multi-row insert fills each page under one latch instead of one
+// fetch/latch/unpin round per tuple
+TEST(TupleTest, BatchInsertBenchmark) {
+  std::string createStmt =
+      "a varchar, b smallint, c bigint, d bool, e varchar(16)";
+  Schema *schema = ParseCreateStatement(createStmt);
+  Tuple tuple = ConstructTuple(schema);
+
+  Transaction *transaction = new Transaction(0);
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *buffer_pool_manager =
+      new BufferPoolManager(BUFFER_POOL_SIZE, disk_manager);
+  LockManager *lock_manager = new LockManager(true);
+  LogManager *log_manager = new LogManager(disk_manager);
+  TableHeap *table = new TableHeap(buffer_pool_manager, lock_manager,
+                                   log_manager, transaction);
+
+  const int count = 20000;
+  RID rid;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i)
+    EXPECT_TRUE(table->InsertTuple(tuple, rid, transaction));
+  std::chrono::duration<double> single_time =
+      std::chrono::steady_clock::now() - start;
+
+  std::vector<Tuple> tuples(count, tuple);
+  std::vector<RID> rids;
+  start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(table->InsertTuples(tuples, rids, transaction));
+  std::chrono::duration<double> batch_time =
+      std::chrono::steady_clock::now() - start;
+  std::cout << "single: " << count / single_time.count() << " inserts/s, "
+            << "batch: " << count / batch_time.count() << " inserts/s"
+            << std::endl;
+
+  ASSERT_EQ(static_cast<size_t>(count), rids.size());
+  for (auto &r : rids) {
+    Tuple result;
+    EXPECT_TRUE(table->GetTuple(r, result, transaction));
+    EXPECT_EQ(tuple.GetLength(), result.GetLength());
+  }
+  int scanned = 0;
+  for (auto itr = table->begin(transaction); itr != table->end(); ++itr)
+    scanned++;
+  EXPECT_EQ(2 * count, scanned);
+
+  delete table;
+  delete buffer_pool_manager;
+  delete log_manager;
+  delete lock_manager;
+  delete disk_manager;
+  delete transaction;
+  delete schema;
+  remove("test.db");
+  remove("test.log");
+}
+
 } // namespace scudb
@@ -1,6 +1,9 @@
 /**
  * virtual_table_test.cpp
  */
+#include <fstream>
+#include <vector>
+
 #include "vtable/testing_vtable_util.h"
 
 namespace scudb {
@@ -33,9 +36,23 @@ TEST(VtableTest, CreateTest) {
   EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo1 VALUES(3, 4, 5, 'Nihao',4, 1)"));
   EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo1 VALUES(2, 3, 4, 'world',3, 1)"));
   EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo1"));
+  EXPECT_TRUE(
+      ExecSQL(db, "SELECT * FROM foo1 WHERE b > 2 AND b <= 4 ORDER BY b"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo1 ORDER BY b"));
+  // index-only scans, only indexed columns are read
+  EXPECT_TRUE(ExecSQL(db, "SELECT b FROM foo1 WHERE b >= 3"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT count(*) FROM foo1"));
+  // duplicate key, both rows are indexed
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo1 VALUES(5, 3, 6, 'again',3, 0)"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo1 WHERE b = 3"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo1 WHERE a = 5"));
   EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo1 WHERE b = 2"));
   EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo1"));
+  // the heap and the index each have a data file, dropped with the table
+  EXPECT_TRUE(std::ifstream("vtable_2.db").good());
   EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo1"));
+  EXPECT_FALSE(std::ifstream("vtable_1.db").good());
+  EXPECT_FALSE(std::ifstream("vtable_2.db").good());
 
   rc = sqlite3_close(db);
   EXPECT_EQ(rc, SQLITE_OK);
@@ -44,4 +61,191 @@ TEST(VtableTest, CreateTest) {
   remove("vtable.db");
   return;
 }
+
+/** Included columns answer queries from the index leaves
+ */
+TEST(VtableTest, IncludeTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, "libvtable", 0, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo2 USING vtable ('a INT, "
+                          "b varchar(8), c double', 'foo2_a a include (b)')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(2, 'world', 2.5)"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo2 VALUES(1, 'hello', 1.5)"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT a, b FROM foo2 WHERE a = 2"));
+  EXPECT_TRUE(ExecSQL(db, "UPDATE foo2 SET b = 'again' WHERE a = 1"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT b FROM foo2 WHERE a >= 1"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo2"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+TEST(VtableTest, FilterTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, "libvtable", 0, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  // keys cut to a prefix can't be kept unique
+  EXPECT_FALSE(ExecSQL(db, "CREATE VIRTUAL TABLE foo6 USING vtable ('a "
+                           "varchar(200), b INT', 'unique foo6_a a')"));
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo3 USING vtable ('a INT, "
+                          "b varchar(8)', 'unique bloom foo3_a a')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo3 VALUES(1, 'hello')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo3 VALUES(3, 'world')"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo3 WHERE a = 2"));
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM foo3 WHERE a = 3"));
+  // a duplicate of a unique key is rejected, and its row is not inserted
+  EXPECT_FALSE(ExecSQL(db, "INSERT INTO foo3 VALUES(3, 'again')"));
+  EXPECT_EQ(sqlite3_extended_errcode(db), SQLITE_CONSTRAINT_UNIQUE);
+  EXPECT_FALSE(ExecSQL(db, "UPDATE foo3 SET a = 3 WHERE a = 1"));
+  EXPECT_TRUE(ExecSQL(db, "UPDATE foo3 SET b = 'again' WHERE a = 1"));
+  sqlite3_stmt *stmt;
+  rc = sqlite3_prepare_v2(db, "SELECT count(*) FROM foo3 WHERE a = 3", -1,
+                          &stmt, 0);
+  EXPECT_EQ(rc, SQLITE_OK);
+  EXPECT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_EQ(sqlite3_column_int(stmt, 0), 1);
+  sqlite3_finalize(stmt);
+  EXPECT_TRUE(ExecSQL(db, "SELECT * FROM index_filter('foo3')"));
+  EXPECT_FALSE(ExecSQL(db, "SELECT * FROM index_filter()"));
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo3"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+/** Rows held back, written rows and their index entries are all undone by
+ *  ROLLBACK and ROLLBACK TO
+ */
+TEST(VtableTest, RollbackTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, "libvtable", 0, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo4 USING vtable ('a INT, "
+                          "b INT', 'foo4_a a')"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(1, 10), (2, 20)"));
+  EXPECT_TRUE(ExecSQL(db, "BEGIN"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(3, 30), (4, 40)"));
+  EXPECT_TRUE(ExecSQL(db, "UPDATE foo4 SET a = 5 WHERE a = 1"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo4 WHERE a = 2"));
+  EXPECT_TRUE(ExecSQL(db, "SAVEPOINT foo"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(6, 60)"));
+  EXPECT_TRUE(ExecSQL(db, "ROLLBACK TO foo"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo4 VALUES(7, 70)"));
+  EXPECT_TRUE(ExecSQL(db, "ROLLBACK"));
+
+  // both the table heap and the index hold the rows before BEGIN only
+  std::vector<std::pair<std::string, int>> queries = {
+      {"SELECT count(*) FROM foo4", 2},
+      {"SELECT count(*) FROM foo4 WHERE a >= 1", 2},
+      {"SELECT sum(a) FROM foo4 WHERE a <= 7", 3}};
+  for (auto &query : queries) {
+    sqlite3_stmt *stmt;
+    rc = sqlite3_prepare_v2(db, query.first.c_str(), -1, &stmt, 0);
+    EXPECT_EQ(rc, SQLITE_OK);
+    EXPECT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+    EXPECT_EQ(sqlite3_column_int(stmt, 0), query.second);
+    sqlite3_finalize(stmt);
+  }
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo4"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
+
+/** A table may be written while an index range scan over it is still being
+ *  stepped
+ */
+TEST(VtableTest, ScanWriteTest) {
+  std::string db_file = "sqlite.db";
+  remove(db_file.c_str());
+  remove("vtable.db");
+  sqlite3 *db;
+  int rc;
+  rc = sqlite3_open(db_file.c_str(), &db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  rc = sqlite3_enable_load_extension(db, 1);
+  EXPECT_EQ(rc, SQLITE_OK);
+  char *zErrMsg = 0;
+  rc = sqlite3_load_extension(db, "libvtable", 0, &zErrMsg);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  EXPECT_TRUE(ExecSQL(db, "CREATE VIRTUAL TABLE foo5 USING vtable ('a INT, "
+                          "b INT', 'foo5_a a')"));
+  EXPECT_TRUE(ExecSQL(db, "WITH RECURSIVE n(x) AS (SELECT 1 UNION ALL SELECT "
+                          "x + 1 FROM n WHERE x < 200) INSERT INTO foo5 "
+                          "SELECT x, x FROM n"));
+  sqlite3_stmt *stmt;
+  rc = sqlite3_prepare_v2(db, "SELECT a FROM foo5 WHERE a > 50", -1, &stmt,
+                          0);
+  EXPECT_EQ(rc, SQLITE_OK);
+  EXPECT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_EQ(sqlite3_column_int(stmt, 0), 51);
+  // the scan holds no latch on the leaves the writes go to
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo5 WHERE a = 52"));
+  EXPECT_TRUE(ExecSQL(db, "DELETE FROM foo5 WHERE a = 150"));
+  EXPECT_TRUE(ExecSQL(db, "INSERT INTO foo5 VALUES(300, 300)"));
+  // the deleted rows are skipped, the inserted one is seen
+  int rows = 1, last = 51;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    EXPECT_GT(sqlite3_column_int(stmt, 0), last);
+    last = sqlite3_column_int(stmt, 0);
+    EXPECT_NE(last, 52);
+    EXPECT_NE(last, 150);
+    rows++;
+  }
+  sqlite3_finalize(stmt);
+  EXPECT_EQ(last, 300);
+  EXPECT_EQ(rows, 149);
+  EXPECT_TRUE(ExecSQL(db, "DROP TABLE foo5"));
+
+  rc = sqlite3_close(db);
+  EXPECT_EQ(rc, SQLITE_OK);
+
+  remove(db_file.c_str());
+  remove("vtable.db");
+}
 } // namespace scudb